@@ -0,0 +1,56 @@
+# Translates several inputs in one hipacc process with concurrent jobs and
+# checks that the generated files match those of separate hipacc runs. Build
+# hipacc with -fsanitize=thread to check the concurrent jobs for data races.
+#
+# cmake -DHIPACC=<bin> -DHIPACC_FLAGS=<flag>,... -DSOURCES=<file>,...
+#       -DWORK_DIR=<dir> [-DJOBS=<n>] -P batch_mode.cmake
+
+if(NOT HIPACC OR NOT SOURCES OR NOT WORK_DIR)
+    message(FATAL_ERROR "HIPACC, SOURCES and WORK_DIR have to be set")
+endif()
+if(NOT JOBS)
+    set(JOBS 2)
+endif()
+string(REPLACE "," ";" HIPACC_FLAGS "${HIPACC_FLAGS}")
+string(REPLACE "," ";" SOURCES "${SOURCES}")
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/single ${WORK_DIR}/batch)
+
+# reference: one hipacc process per input
+set(batch_file ${WORK_DIR}/inputs.txt)
+file(WRITE ${batch_file} "")
+foreach(source ${SOURCES})
+    get_filename_component(name ${source} NAME_WE)
+    execute_process(COMMAND ${HIPACC} ${HIPACC_FLAGS} ${source} -o ${name}.cc
+                    WORKING_DIRECTORY ${WORK_DIR}/single
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "hipacc failed for ${source}: ${result}")
+    endif()
+    file(APPEND ${batch_file} "${source} -o ${name}.cc\n")
+endforeach()
+
+execute_process(COMMAND ${HIPACC} ${HIPACC_FLAGS} -batch ${batch_file} -j ${JOBS}
+                WORKING_DIRECTORY ${WORK_DIR}/batch
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "hipacc -batch failed: ${result}")
+endif()
+
+file(GLOB expected RELATIVE ${WORK_DIR}/single ${WORK_DIR}/single/*.cc)
+file(GLOB generated RELATIVE ${WORK_DIR}/batch ${WORK_DIR}/batch/*.cc)
+if(NOT expected STREQUAL generated)
+    message(FATAL_ERROR "batch mode generated '${generated}' instead of '${expected}'")
+endif()
+foreach(file ${expected})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/single/${file} ${WORK_DIR}/batch/${file}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${file} differs between batch mode and a separate run")
+    endif()
+endforeach()
+
+list(LENGTH SOURCES num_sources)
+list(LENGTH expected num_files)
+message(STATUS "${num_sources} inputs with ${JOBS} jobs: ${num_files} files identical to separate runs")
@@ -0,0 +1,190 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Common harness for the Hipacc benchmark programs. The programs are plain
+// Hipacc DSL sources: they are translated by hipacc for the benchmark suite,
+// but can also be compiled directly against the DSL headers.
+
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+// image size and pixel type are compile-time constants for the generated code
+#ifndef WIDTH
+# define WIDTH 1024
+#endif
+#ifndef HEIGHT
+# define HEIGHT 1024
+#endif
+#ifndef DATA_TYPE
+# define DATA_TYPE float
+#endif
+
+#define BENCH_STRINGIFY2(x) #x
+#define BENCH_STRINGIFY(x) BENCH_STRINGIFY2(x)
+
+
+inline int bench_iterations() {
+    const char *env = std::getenv("HIPACC_BENCH_ITERATIONS");
+    int iterations = env ? std::atoi(env) : 0;
+    return iterations > 0 ? iterations : 10;
+}
+
+
+inline int bench_threads() {
+    #ifdef _OPENMP
+    return omp_get_max_threads();
+    #else
+    const char *env = std::getenv("OMP_NUM_THREADS");
+    int threads = env ? std::atoi(env) : 0;
+    return threads > 0 ? threads : 1;
+    #endif
+}
+
+
+// Deterministic input data in the range [0, 255]
+template<typename T>
+T *bench_input(int width, int height) {
+    T *data = new T[width*height];
+    unsigned int seed = 42;
+    for (int i = 0; i < width*height; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (T)((seed >> 16) % 256);
+    }
+    return data;
+}
+
+
+// Write an output image to $HIPACC_BENCH_DUMP/<name>.raw for the
+// differential test: a text header "HIPACCRAW <type> <width> <height>"
+// followed by the raw pixel data
+#define bench_dump(name, data, width, height) \
+    bench_dump_raw(name, BENCH_STRINGIFY(DATA_TYPE), data, width, height)
+
+template<typename T>
+void bench_dump_raw(const char *name, const char *type, const T *data,
+                    int width, int height) {
+    const char *dir = std::getenv("HIPACC_BENCH_DUMP");
+    if (dir == nullptr) return;
+
+    std::string file = std::string(dir) + "/" + name + ".raw";
+    FILE *out = std::fopen(file.c_str(), "wb");
+    if (out == nullptr) {
+        std::fprintf(stderr, "ERROR: Could not open %s\n", file.c_str());
+        std::exit(EXIT_FAILURE);
+    }
+    std::fprintf(out, "HIPACCRAW %s %d %d\n", type, width, height);
+    std::fwrite(data, sizeof(T), (size_t)width*height, out);
+    std::fclose(out);
+}
+
+
+class BenchTimer {
+    private:
+        std::chrono::high_resolution_clock::time_point start_;
+        std::vector<double> times_;
+
+    public:
+        void start() {
+            start_ = std::chrono::high_resolution_clock::now();
+        }
+
+        void stop() {
+            auto end = std::chrono::high_resolution_clock::now();
+            times_.push_back(std::chrono::duration<double, std::milli>(end - start_).count());
+        }
+
+        void add(double time) {
+            times_.push_back(time);
+        }
+
+        double median() const {
+            if (times_.empty()) return 0.0;
+            std::vector<double> sorted(times_);
+            std::sort(sorted.begin(), sorted.end());
+            return sorted[sorted.size()/2];
+        }
+
+        double min() const {
+            if (times_.empty()) return 0.0;
+            return *std::min_element(times_.begin(), times_.end());
+        }
+
+        size_t iterations() const { return times_.size(); }
+};
+
+
+// Per-kernel timings as measured by the DSL or the runtime, recorded with
+// hipacc_last_kernel_timing() after each kernel invocation
+inline std::map<std::string, BenchTimer> &bench_kernel_timers() {
+    static std::map<std::string, BenchTimer> timers;
+    return timers;
+}
+
+inline void bench_kernel(const char *name, double time) {
+    bench_kernel_timers()[name].add(time);
+}
+
+
+// Print one result as a single line of JSON. bytes_per_pixel is the
+// compulsory memory traffic per output pixel, used for the GB/s estimate.
+inline void bench_report(const char *name, int width, int height,
+                         const BenchTimer &timer, double bytes_per_pixel) {
+    double median = timer.median();
+    double pixels = (double)width * height;
+    double mpixels = median > 0.0 ? pixels / (median * 1.0e3) : 0.0;
+    double gbytes  = median > 0.0 ? pixels * bytes_per_pixel / (median * 1.0e6) : 0.0;
+
+    std::printf("{\"benchmark\": \"%s\", \"type\": \"%s\", \"width\": %d, "
+                "\"height\": %d, \"threads\": %d, \"iterations\": %zu, "
+                "\"median_ms\": %.4f, \"min_ms\": %.4f, \"mpixel_s\": %.2f, "
+                "\"gb_s\": %.3f, \"kernels\": {",
+                name, BENCH_STRINGIFY(DATA_TYPE), width, height,
+                bench_threads(), timer.iterations(), median, timer.min(),
+                mpixels, gbytes);
+
+    // median time per call of each kernel
+    const char *separator = "";
+    for (auto &kernel : bench_kernel_timers()) {
+        std::printf("%s\"%s\": {\"calls\": %zu, \"median_ms\": %.4f}",
+                    separator, kernel.first.c_str(),
+                    kernel.second.iterations(), kernel.second.median());
+        separator = ", ";
+    }
+    std::printf("}}\n");
+}
+
+#endif // __BENCH_HPP__
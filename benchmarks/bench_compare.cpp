@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Differential check between two runs of a benchmark program, one built
+// against the DSL headers (reference) and one translated by hipacc: compares
+// all images dumped by the reference run and reports the speedup per kernel.
+//
+// Usage: bench_compare [-a <abs_tolerance>] [-r <rel_tolerance>] <ref_dir> <test_dir>
+//
+// Both directories hold the .raw images written by bench_dump and the
+// result line of the run in result.json.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+
+struct raw_image {
+    std::string type;
+    int width = 0, height = 0;
+    std::vector<double> pixels;
+};
+
+
+template<typename T>
+void read_pixels(std::istream &in, raw_image &img) {
+    std::vector<T> data((size_t)img.width * img.height);
+    in.read((char *)data.data(), data.size() * sizeof(T));
+    img.pixels.assign(data.begin(), data.end());
+}
+
+
+bool read_raw(const std::string &file, raw_image &img) {
+    std::ifstream in(file, std::ios::binary);
+    std::string magic;
+    if (!(in >> magic >> img.type >> img.width >> img.height) || magic != "HIPACCRAW")
+        return false;
+    in.get();
+
+    if      (img.type == "float")  read_pixels<float>(in, img);
+    else if (img.type == "double") read_pixels<double>(in, img);
+    else if (img.type == "char")   read_pixels<char>(in, img);
+    else if (img.type == "uchar")  read_pixels<unsigned char>(in, img);
+    else if (img.type == "short")  read_pixels<short>(in, img);
+    else if (img.type == "ushort") read_pixels<unsigned short>(in, img);
+    else if (img.type == "int")    read_pixels<int>(in, img);
+    else if (img.type == "uint")   read_pixels<unsigned int>(in, img);
+    else return false;
+
+    return (bool)in;
+}
+
+
+std::vector<std::string> list_images(const std::string &dir) {
+    std::vector<std::string> names;
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *entry = readdir(d)) {
+            std::string name(entry->d_name);
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".raw") == 0)
+                names.push_back(name.substr(0, name.size() - 4));
+        }
+        closedir(d);
+    }
+    return names;
+}
+
+
+// benchmark name, total and per-kernel median times from a result line
+struct run_result {
+    std::string benchmark;
+    double median_ms = 0;
+    std::map<std::string, double> kernels;
+};
+
+bool read_result(const std::string &file, run_result &result) {
+    std::ifstream in(file);
+    std::string line;
+    if (!std::getline(in, line)) return false;
+
+    std::smatch match;
+    if (std::regex_search(line, match, std::regex("\"benchmark\": \"([^\"]*)\"")))
+        result.benchmark = match[1];
+    if (std::regex_search(line, match, std::regex("\"median_ms\": ([0-9.]+), \"min_ms\"")))
+        result.median_ms = std::atof(match[1].str().c_str());
+    else
+        return false;
+
+    std::regex kernel("\"(\\w+)\": \\{\"calls\": [0-9]+, \"median_ms\": ([0-9.]+)\\}");
+    for (std::sregex_iterator it(line.begin(), line.end(), kernel), end; it != end; ++it)
+        result.kernels[(*it)[1]] = std::atof((*it)[2].str().c_str());
+
+    return true;
+}
+
+
+double speedup(double ref, double test) {
+    return test > 0 ? ref / test : 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    double abs_tolerance = 1.0e-3;
+    double rel_tolerance = 1.0e-4;
+    std::vector<std::string> dirs;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            abs_tolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rel_tolerance = std::atof(argv[++i]);
+        } else {
+            dirs.push_back(argv[i]);
+        }
+    }
+    if (dirs.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " [-a <abs_tolerance>] [-r <rel_tolerance>] <ref_dir> <test_dir>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool match = true;
+    double max_error = 0;
+    std::vector<std::string> names = list_images(dirs[0]);
+    if (names.empty()) {
+        std::cerr << "ERROR: No reference images in " << dirs[0] << std::endl;
+        match = false;
+    }
+
+    for (auto &name : names) {
+        raw_image ref, test;
+        if (!read_raw(dirs[0] + "/" + name + ".raw", ref) ||
+            !read_raw(dirs[1] + "/" + name + ".raw", test)) {
+            std::cerr << "ERROR: Could not read image '" << name << "'" << std::endl;
+            match = false;
+            continue;
+        }
+        if (ref.type != test.type || ref.width != test.width || ref.height != test.height) {
+            std::cerr << "ERROR: Image '" << name << "' differs in type or size" << std::endl;
+            match = false;
+            continue;
+        }
+
+        size_t mismatches = 0, first = 0;
+        for (size_t i = 0; i < ref.pixels.size(); ++i) {
+            double error = std::fabs(ref.pixels[i] - test.pixels[i]);
+            max_error = std::max(max_error, error);
+            if (error > abs_tolerance + rel_tolerance * std::fabs(ref.pixels[i]) ||
+                std::isnan(test.pixels[i]) != std::isnan(ref.pixels[i])) {
+                if (!mismatches) first = i;
+                ++mismatches;
+            }
+        }
+        if (mismatches) {
+            std::cerr << "ERROR: Image '" << name << "': " << mismatches
+                      << " pixels out of tolerance, first at (" << first % ref.width
+                      << ", " << first / ref.width << "): " << ref.pixels[first]
+                      << " (reference) vs. " << test.pixels[first] << std::endl;
+            match = false;
+        }
+    }
+
+    run_result ref, test;
+    if (!read_result(dirs[0] + "/result.json", ref) ||
+        !read_result(dirs[1] + "/result.json", test)) {
+        std::cerr << "ERROR: Could not read benchmark results" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::printf("{\"benchmark\": \"%s\", \"match\": %s, \"max_abs_error\": %g, "
+                "\"speedup\": %.2f, \"kernels\": {", ref.benchmark.c_str(),
+                match ? "true" : "false", max_error,
+                speedup(ref.median_ms, test.median_ms));
+    const char *separator = "";
+    for (auto &kernel : ref.kernels) {
+        auto it = test.kernels.find(kernel.first);
+        if (it == test.kernels.end()) continue;
+        std::printf("%s\"%s\": %.2f", separator, kernel.first.c_str(),
+                    speedup(kernel.second, it->second));
+        separator = ", ";
+    }
+    std::printf("}}\n");
+
+    return match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
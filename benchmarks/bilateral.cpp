@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Bilateral filter over a 13x13 window
+class BilateralFilter : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Domain &dom;
+        float sigma_d;
+        float sigma_r;
+
+    public:
+        BilateralFilter(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                        Domain &dom, float sigma_d, float sigma_r)
+            : Kernel(iter), input(input), dom(dom), sigma_d(sigma_d),
+              sigma_r(sigma_r) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            float c_d = 1.0f/(2.0f*sigma_d*sigma_d);
+            float c_r = 1.0f/(2.0f*sigma_r*sigma_r);
+            float center = input();
+            float d = 0.0f;
+            float p = 0.0f;
+
+            iterate(dom, [&] () -> void {
+                    float pixel = input(dom);
+                    float diff = pixel - center;
+                    float s = expf(-c_r * diff*diff) *
+                              expf(-c_d * dom.x()*dom.x()) *
+                              expf(-c_d * dom.y()*dom.y());
+                    d += s;
+                    p += s * pixel;
+                });
+
+            output() = (DATA_TYPE)(p/d + 0.5f);
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const float sigma_d = 3.0f;
+    const float sigma_r = 20.0f;
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Domain dom(13, 13);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out(width, height);
+    BoundaryCondition<DATA_TYPE> bound(in, dom, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc(bound);
+    IterationSpace<DATA_TYPE> iter(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        BilateralFilter filter(iter, acc, dom, sigma_d, sigma_r);
+        timer.start();
+        filter.execute();
+        bench_kernel("BilateralFilter", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    bench_report("bilateral", width, height, timer, 2*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// 5x5 box filter followed by a 3x3 median filter
+class BoxFilter : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Domain &dom;
+
+    public:
+        BoxFilter(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                  Domain &dom)
+            : Kernel(iter), input(input), dom(dom) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            float sum = reduce(dom, Reduce::SUM, [&] () -> float {
+                    return input(dom);
+                });
+            output() = (DATA_TYPE)(sum/25.0f + 0.5f);
+        }
+};
+
+
+class MedianFilter : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        MedianFilter(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            DATA_TYPE v[9];
+            v[0] = input(-1, -1); v[1] = input(0, -1); v[2] = input(1, -1);
+            v[3] = input(-1,  0); v[4] = input(0,  0); v[5] = input(1,  0);
+            v[6] = input(-1,  1); v[7] = input(0,  1); v[8] = input(1,  1);
+
+            // partial selection sort up to the median
+            for (int i = 0; i < 5; ++i) {
+                for (int j = i + 1; j < 9; ++j) {
+                    if (v[j] < v[i]) {
+                        DATA_TYPE tmp = v[i];
+                        v[i] = v[j];
+                        v[j] = tmp;
+                    }
+                }
+            }
+
+            output() = v[4];
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Domain dom(5, 5);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> box(width, height);
+    Image<DATA_TYPE> out(width, height);
+
+    BoundaryCondition<DATA_TYPE> bound_in(in, dom, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc_in(bound_in);
+    BoundaryCondition<DATA_TYPE> bound_box(box, 3, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc_box(bound_box);
+    IterationSpace<DATA_TYPE> iter_box(box);
+    IterationSpace<DATA_TYPE> iter_out(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        BoxFilter box_filter(iter_box, acc_in, dom);
+        MedianFilter median_filter(iter_out, acc_box);
+        timer.start();
+        box_filter.execute();
+        bench_kernel("BoxFilter", hipacc_last_kernel_timing());
+        median_filter.execute();
+        bench_kernel("MedianFilter", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    bench_report("box_median", width, height, timer, 4*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+# Runs a single benchmark binary and compares its throughput against the
+# stored baseline. Fails if the throughput dropped by more than the tolerance
+# or if the baseline has no entry for the benchmark.
+#
+# cmake -DBENCH_BINARY=<bin> -DBENCH_BASELINE=<file> -DBENCH_TOLERANCE=<percent>
+#       -DBENCH_ITERATIONS=<n> -P check_regression.cmake
+
+if(NOT BENCH_BINARY OR NOT BENCH_BASELINE)
+    message(FATAL_ERROR "BENCH_BINARY and BENCH_BASELINE have to be set")
+endif()
+if(NOT BENCH_TOLERANCE)
+    set(BENCH_TOLERANCE 25)
+endif()
+if(NOT BENCH_ITERATIONS)
+    set(BENCH_ITERATIONS 10)
+endif()
+
+# the baseline is recorded single-threaded, compare the same configuration
+execute_process(COMMAND ${CMAKE_COMMAND} -E env OMP_NUM_THREADS=1
+                                                HIPACC_BENCH_ITERATIONS=${BENCH_ITERATIONS}
+                                                ${BENCH_BINARY}
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${BENCH_BINARY} failed: ${result}")
+endif()
+
+string(REGEX MATCH "{\"benchmark\"[^\n]*" line "${output}")
+if(NOT line)
+    message(FATAL_ERROR "${BENCH_BINARY} did not report a result")
+endif()
+
+# benchmark, type, size and thread count identify the baseline entry
+string(REGEX MATCH "^.*\"threads\": [0-9]+," key "${line}")
+string(REGEX REPLACE ".*\"mpixel_s\": ([0-9.]+).*" "\\1" current "${line}")
+string(REGEX REPLACE "^{\"benchmark\": \"([^\"]*)\", \"type\": \"([^\"]*)\", \"width\": ([0-9]+), \"height\": ([0-9]+).*"
+                     "\\1 (\\2, \\3x\\4)" label "${line}")
+
+set(baseline "")
+if(EXISTS ${BENCH_BASELINE})
+    file(STRINGS ${BENCH_BASELINE} baseline_lines)
+    foreach(baseline_line ${baseline_lines})
+        string(FIND "${baseline_line}" "${key}" pos)
+        if(pos EQUAL 0)
+            string(REGEX REPLACE ".*\"mpixel_s\": ([0-9.]+).*" "\\1" baseline "${baseline_line}")
+        endif()
+    endforeach()
+endif()
+
+if(NOT baseline)
+    message(FATAL_ERROR "no baseline for ${label} (${current} Mpixel/s) in ${BENCH_BASELINE}: "
+                        "record one with the hipacc_bench_baseline target and copy it there")
+endif()
+
+# math(EXPR) is integer only: compare in units of 0.01 Mpixel/s
+string(REPLACE "." "" current_int "${current}")
+string(REPLACE "." "" baseline_int "${baseline}")
+math(EXPR current_scaled "${current_int} * 100")
+math(EXPR baseline_scaled "${baseline_int} * (100 - ${BENCH_TOLERANCE})")
+
+message(STATUS "${label}: ${current} Mpixel/s (baseline ${baseline} Mpixel/s, tolerance ${BENCH_TOLERANCE}%)")
+if(current_scaled LESS baseline_scaled)
+    message(FATAL_ERROR "performance regression: ${current} Mpixel/s is more than ${BENCH_TOLERANCE}% below the baseline of ${baseline} Mpixel/s")
+endif()
@@ -0,0 +1,77 @@
+# Runs a benchmark program built against the DSL headers (reference) and its
+# hipacc-translated counterpart, compares their output images and reports
+# the speedup per kernel.
+#
+# cmake -DBENCH_REFERENCE=<bin> -DBENCH_GENERATED=<bin> -DBENCH_COMPARE=<bin>
+#       -DBENCH_WORK_DIR=<dir> [-DBENCH_ITERATIONS=<n>]
+#       [-DBENCH_ABS_TOLERANCE=<x>] [-DBENCH_REL_TOLERANCE=<x>]
+#       [-DBENCH_RESULTS=<file>] [-DBENCH_RUN_DIR=<dir>]
+#       [-DBENCH_ENV=<var>=<value>,...] -P differential.cmake
+#
+# BENCH_RUN_DIR and BENCH_ENV only apply to the generated program, e.g. the
+# directory of its OpenCL kernel files and runtime settings.
+
+if(NOT BENCH_REFERENCE OR NOT BENCH_GENERATED OR NOT BENCH_COMPARE OR NOT BENCH_WORK_DIR)
+    message(FATAL_ERROR "BENCH_REFERENCE, BENCH_GENERATED, BENCH_COMPARE and BENCH_WORK_DIR have to be set")
+endif()
+if(NOT BENCH_ITERATIONS)
+    set(BENCH_ITERATIONS 3)
+endif()
+
+set(compare_flags "")
+if(BENCH_ABS_TOLERANCE)
+    list(APPEND compare_flags -a ${BENCH_ABS_TOLERANCE})
+endif()
+if(BENCH_REL_TOLERANCE)
+    list(APPEND compare_flags -r ${BENCH_REL_TOLERANCE})
+endif()
+
+if(NOT BENCH_RUN_DIR)
+    set(BENCH_RUN_DIR ${BENCH_WORK_DIR})
+endif()
+string(REPLACE "," ";" BENCH_ENV "${BENCH_ENV}")
+
+foreach(run reference generated)
+    set(dir ${BENCH_WORK_DIR}/${run})
+    file(REMOVE_RECURSE ${dir})
+    file(MAKE_DIRECTORY ${dir})
+
+    if(run STREQUAL "reference")
+        set(binary ${BENCH_REFERENCE})
+        set(env "")
+        set(run_dir ${dir})
+    else()
+        set(binary ${BENCH_GENERATED})
+        set(env ${BENCH_ENV})
+        set(run_dir ${BENCH_RUN_DIR})
+    endif()
+
+    # single-threaded, the DSL reference does not use OpenMP
+    execute_process(COMMAND ${CMAKE_COMMAND} -E env OMP_NUM_THREADS=1
+                                                    HIPACC_BENCH_ITERATIONS=${BENCH_ITERATIONS}
+                                                    HIPACC_BENCH_DUMP=${dir}
+                                                    ${env}
+                                                    ${binary}
+                    WORKING_DIRECTORY ${run_dir}
+                    RESULT_VARIABLE result
+                    OUTPUT_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${binary} failed: ${result}")
+    endif()
+
+    string(REGEX MATCH "{\"benchmark\"[^\n]*" line "${output}")
+    file(WRITE ${dir}/result.json "${line}\n")
+endforeach()
+
+execute_process(COMMAND ${BENCH_COMPARE} ${compare_flags} ${BENCH_WORK_DIR}/reference ${BENCH_WORK_DIR}/generated
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+message(STATUS "${output}")
+if(BENCH_RESULTS)
+    file(APPEND ${BENCH_RESULTS} "${output}\n")
+endif()
+
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "output of ${BENCH_GENERATED} differs from the DSL reference")
+endif()
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Gaussian blur with a 5x5 filter mask
+class GaussianBlur : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Mask<float> &mask;
+
+    public:
+        GaussianBlur(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                     Mask<float> &mask)
+            : Kernel(iter), input(input), mask(mask) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = (DATA_TYPE)(convolve(mask, Reduce::SUM, [&] () -> float {
+                    return mask() * input(mask);
+                }) + 0.5f);
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const float coef[5][5] = {
+        { 0.003765f, 0.015019f, 0.023792f, 0.015019f, 0.003765f },
+        { 0.015019f, 0.059912f, 0.094907f, 0.059912f, 0.015019f },
+        { 0.023792f, 0.094907f, 0.150342f, 0.094907f, 0.023792f },
+        { 0.015019f, 0.059912f, 0.094907f, 0.059912f, 0.015019f },
+        { 0.003765f, 0.015019f, 0.023792f, 0.015019f, 0.003765f }
+    };
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Mask<float> mask(coef);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out(width, height);
+    BoundaryCondition<DATA_TYPE> bound(in, mask, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc(bound);
+    IterationSpace<DATA_TYPE> iter(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        GaussianBlur filter(iter, acc, mask);
+        timer.start();
+        filter.execute();
+        bench_kernel("GaussianBlur", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    bench_report("gaussian", width, height, timer, 2*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Harris corner detection: derivatives, blurred structure tensor and corner
+// response, computed by a pipeline of six kernels
+class Derivative : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Mask<float> &mask;
+
+    public:
+        Derivative(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                   Mask<float> &mask)
+            : Kernel(iter), input(input), mask(mask) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> DATA_TYPE {
+                    return mask() * input(mask);
+                });
+        }
+};
+
+
+class BlurProduct : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input1;
+        Accessor<DATA_TYPE> &input2;
+        Mask<float> &mask;
+
+    public:
+        BlurProduct(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input1,
+                    Accessor<DATA_TYPE> &input2, Mask<float> &mask)
+            : Kernel(iter), input1(input1), input2(input2), mask(mask) {
+            add_accessor(&input1);
+            add_accessor(&input2);
+        }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> DATA_TYPE {
+                    return mask() * input1(mask) * input2(mask);
+                });
+        }
+};
+
+
+class Response : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &sxx;
+        Accessor<DATA_TYPE> &syy;
+        Accessor<DATA_TYPE> &sxy;
+        float k;
+
+    public:
+        Response(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &sxx,
+                 Accessor<DATA_TYPE> &syy, Accessor<DATA_TYPE> &sxy, float k)
+            : Kernel(iter), sxx(sxx), syy(syy), sxy(sxy), k(k) {
+            add_accessor(&sxx);
+            add_accessor(&syy);
+            add_accessor(&sxy);
+        }
+
+        void kernel() {
+            DATA_TYPE xx = sxx();
+            DATA_TYPE yy = syy();
+            DATA_TYPE xy = sxy();
+            DATA_TYPE det = xx*yy - xy*xy;
+            DATA_TYPE trace = xx + yy;
+            output() = det - k*trace*trace;
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const float k = 0.04f;
+    const float coef_x[3][3] = {
+        { -0.166666667f, 0.0f, 0.166666667f },
+        { -0.166666667f, 0.0f, 0.166666667f },
+        { -0.166666667f, 0.0f, 0.166666667f }
+    };
+    const float coef_y[3][3] = {
+        { -0.166666667f, -0.166666667f, -0.166666667f },
+        {  0.0f,          0.0f,          0.0f         },
+        {  0.166666667f,  0.166666667f,  0.166666667f }
+    };
+    const float coef_g[3][3] = {
+        { 0.057118f, 0.124758f, 0.057118f },
+        { 0.124758f, 0.272496f, 0.124758f },
+        { 0.057118f, 0.124758f, 0.057118f }
+    };
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Mask<float> mask_x(coef_x);
+    Mask<float> mask_y(coef_y);
+    Mask<float> mask_g(coef_g);
+
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> dx(width, height);
+    Image<DATA_TYPE> dy(width, height);
+    Image<DATA_TYPE> sxx(width, height);
+    Image<DATA_TYPE> syy(width, height);
+    Image<DATA_TYPE> sxy(width, height);
+    Image<DATA_TYPE> out(width, height);
+
+    BoundaryCondition<DATA_TYPE> bound_in(in, mask_x, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc_in(bound_in);
+    BoundaryCondition<DATA_TYPE> bound_dx(dx, mask_g, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc_dx(bound_dx);
+    BoundaryCondition<DATA_TYPE> bound_dy(dy, mask_g, Boundary::CLAMP);
+    Accessor<DATA_TYPE> acc_dy(bound_dy);
+    Accessor<DATA_TYPE> acc_sxx(sxx);
+    Accessor<DATA_TYPE> acc_syy(syy);
+    Accessor<DATA_TYPE> acc_sxy(sxy);
+
+    IterationSpace<DATA_TYPE> iter_dx(dx);
+    IterationSpace<DATA_TYPE> iter_dy(dy);
+    IterationSpace<DATA_TYPE> iter_sxx(sxx);
+    IterationSpace<DATA_TYPE> iter_syy(syy);
+    IterationSpace<DATA_TYPE> iter_sxy(sxy);
+    IterationSpace<DATA_TYPE> iter_out(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        Derivative derive_x(iter_dx, acc_in, mask_x);
+        Derivative derive_y(iter_dy, acc_in, mask_y);
+        BlurProduct blur_xx(iter_sxx, acc_dx, acc_dx, mask_g);
+        BlurProduct blur_yy(iter_syy, acc_dy, acc_dy, mask_g);
+        BlurProduct blur_xy(iter_sxy, acc_dx, acc_dy, mask_g);
+        Response response(iter_out, acc_sxx, acc_syy, acc_sxy, k);
+
+        timer.start();
+        derive_x.execute();
+        bench_kernel("DerivativeX", hipacc_last_kernel_timing());
+        derive_y.execute();
+        bench_kernel("DerivativeY", hipacc_last_kernel_timing());
+        blur_xx.execute();
+        bench_kernel("BlurProductXX", hipacc_last_kernel_timing());
+        blur_yy.execute();
+        bench_kernel("BlurProductYY", hipacc_last_kernel_timing());
+        blur_xy.execute();
+        bench_kernel("BlurProductXY", hipacc_last_kernel_timing());
+        response.execute();
+        bench_kernel("Response", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    // traffic of the whole pipeline: 2x(1+1), 2x(1+1) + (2+1), 3+1
+    bench_report("harris", width, height, timer, 14*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// 256 bin histogram computed with a global binning operation
+class Histogram : public Kernel<DATA_TYPE, uint> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        Histogram(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = input();
+        }
+
+        void binning(uint x, uint y, DATA_TYPE pixel) {
+            bin((uint)pixel * num_bins() / 256) = 1;
+        }
+
+        uint reduce(uint left, uint right) const {
+            return left + right;
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int num_bins = 256;
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out(width, height);
+    Accessor<DATA_TYPE> acc(in);
+    IterationSpace<DATA_TYPE> iter(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        Histogram histogram(iter, acc);
+        timer.start();
+        uint *bins = histogram.binned_data(num_bins);
+        timer.stop();
+        bench_kernel("Histogram", hipacc_last_kernel_timing());
+        if (i == 0)
+            bench_dump_raw("bins", "uint", bins, num_bins, 1);
+        delete[] bins;
+    }
+
+    bench_report("histogram", width, height, timer, 2*sizeof(DATA_TYPE));
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
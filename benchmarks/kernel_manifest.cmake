@@ -0,0 +1,80 @@
+# Checks that hipacc only rewrites kernel files whose content changed and
+# that the kernel files are correct after an edit is reverted, even if the
+# run with the edit stopped before it updated the kernel manifest.
+#
+# cmake -DHIPACC=<bin> -DHIPACC_FLAGS=<flag>,... -DSOURCE=<file>
+#       -DWORK_DIR=<dir> -P kernel_manifest.cmake
+
+if(NOT HIPACC OR NOT SOURCE OR NOT WORK_DIR)
+    message(FATAL_ERROR "HIPACC, SOURCE and WORK_DIR have to be set")
+endif()
+string(REPLACE "," ";" HIPACC_FLAGS "${HIPACC_FLAGS}")
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(run_hipacc width)
+    execute_process(COMMAND ${HIPACC} ${HIPACC_FLAGS} -DWIDTH=${width} -DHEIGHT=256
+                            ${SOURCE} -o host.cc
+                    WORKING_DIRECTORY ${WORK_DIR}
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "hipacc failed for WIDTH=${width}: ${result}")
+    endif()
+endfunction()
+
+# kernel files with their content and modification time
+function(read_kernels prefix)
+    file(GLOB kernels RELATIVE ${WORK_DIR} ${WORK_DIR}/*.cc)
+    list(REMOVE_ITEM kernels host.cc)
+    if(NOT kernels)
+        message(FATAL_ERROR "hipacc did not write any kernel file")
+    endif()
+    foreach(kernel ${kernels})
+        file(READ ${WORK_DIR}/${kernel} content)
+        file(TIMESTAMP ${WORK_DIR}/${kernel} time "%s")
+        set(${prefix}_${kernel}_content "${content}" PARENT_SCOPE)
+        set(${prefix}_${kernel}_time ${time} PARENT_SCOPE)
+    endforeach()
+    set(${prefix}_kernels ${kernels} PARENT_SCOPE)
+endfunction()
+
+run_hipacc(256)
+read_kernels(initial)
+file(COPY ${WORK_DIR}/hipacc_kernels.manifest DESTINATION ${WORK_DIR}/saved)
+
+# unchanged input: no kernel file is touched
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1)
+run_hipacc(256)
+read_kernels(unchanged)
+foreach(kernel ${initial_kernels})
+    if(NOT unchanged_${kernel}_time EQUAL initial_${kernel}_time)
+        message(FATAL_ERROR "${kernel} was rewritten without a change")
+    endif()
+endforeach()
+
+# edit: the kernels are regenerated
+run_hipacc(512)
+read_kernels(edited)
+set(changed FALSE)
+foreach(kernel ${initial_kernels})
+    if(NOT edited_${kernel}_content STREQUAL initial_${kernel}_content)
+        set(changed TRUE)
+    endif()
+endforeach()
+if(NOT changed)
+    message(FATAL_ERROR "no kernel file changed after the edit")
+endif()
+
+# revert after the run with the edit lost its manifest update, e.g. because
+# it failed or another process replaced the manifest
+file(COPY ${WORK_DIR}/saved/hipacc_kernels.manifest DESTINATION ${WORK_DIR})
+run_hipacc(256)
+read_kernels(reverted)
+foreach(kernel ${initial_kernels})
+    if(NOT reverted_${kernel}_content STREQUAL initial_${kernel}_content)
+        message(FATAL_ERROR "${kernel} is stale after reverting the edit")
+    endif()
+endforeach()
+
+message(STATUS "kernel files are rewritten exactly when their content changes")
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Laplacian pyramid decomposition over eight levels
+class Downsample : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Mask<float> &mask;
+
+    public:
+        Downsample(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                   Mask<float> &mask)
+            : Kernel(iter), input(input), mask(mask) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> DATA_TYPE {
+                    return mask() * input(mask);
+                });
+        }
+};
+
+
+class Subtract : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &fine;
+        Accessor<DATA_TYPE> &coarse;
+
+    public:
+        Subtract(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &fine,
+                 Accessor<DATA_TYPE> &coarse)
+            : Kernel(iter), fine(fine), coarse(coarse) {
+            add_accessor(&fine);
+            add_accessor(&coarse);
+        }
+
+        void kernel() {
+            output() = fine() - coarse();
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int depth = 8;
+    const float coef[5][5] = {
+        { 0.003765f, 0.015019f, 0.023792f, 0.015019f, 0.003765f },
+        { 0.015019f, 0.059912f, 0.094907f, 0.059912f, 0.015019f },
+        { 0.023792f, 0.094907f, 0.150342f, 0.094907f, 0.023792f },
+        { 0.015019f, 0.059912f, 0.094907f, 0.059912f, 0.015019f },
+        { 0.003765f, 0.015019f, 0.023792f, 0.015019f, 0.003765f }
+    };
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Mask<float> mask(coef);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> lap(width, height);
+    Pyramid<DATA_TYPE> pyr_gaus(in, depth);
+    Pyramid<DATA_TYPE> pyr_lap(lap, depth);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer.start();
+        traverse(pyr_gaus, pyr_lap, [&] () {
+            if (!pyr_gaus.is_top_level()) {
+                BoundaryCondition<DATA_TYPE> bound(pyr_gaus(-1), mask, Boundary::CLAMP);
+                Accessor<DATA_TYPE> acc(bound, Interpolate::NN);
+                IterationSpace<DATA_TYPE> iter(pyr_gaus(0));
+                Downsample down(iter, acc, mask);
+                down.execute();
+                bench_kernel("Downsample", hipacc_last_kernel_timing());
+            }
+
+            traverse();
+
+            if (!pyr_gaus.is_bottom_level()) {
+                Accessor<DATA_TYPE> acc_fine(pyr_gaus(0));
+                Accessor<DATA_TYPE> acc_coarse(pyr_gaus(1), Interpolate::LF);
+                IterationSpace<DATA_TYPE> iter(pyr_lap(0));
+                Subtract sub(iter, acc_fine, acc_coarse);
+                sub.execute();
+                bench_kernel("Subtract", hipacc_last_kernel_timing());
+            } else {
+                pyr_lap(0) = pyr_gaus(0);
+            }
+        });
+        timer.stop();
+    }
+
+    // all levels together hold 4/3 of the base image pixels
+    bench_report("laplacian_pyramid", width, height, timer,
+                 4.0*(2+3)/3*sizeof(DATA_TYPE));
+
+    bench_dump("lap", lap.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Global minimum and maximum of an image
+class MinReduction : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        MinReduction(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = input();
+        }
+
+        DATA_TYPE reduce(DATA_TYPE left, DATA_TYPE right) const {
+            return left < right ? left : right;
+        }
+};
+
+
+class MaxReduction : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        MaxReduction(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = input();
+        }
+
+        DATA_TYPE reduce(DATA_TYPE left, DATA_TYPE right) const {
+            return left > right ? left : right;
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out_min(width, height);
+    Image<DATA_TYPE> out_max(width, height);
+    Accessor<DATA_TYPE> acc(in);
+    IterationSpace<DATA_TYPE> iter_min(out_min);
+    IterationSpace<DATA_TYPE> iter_max(out_max);
+
+    DATA_TYPE result[2];
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        MinReduction red_min(iter_min, acc);
+        MaxReduction red_max(iter_max, acc);
+        timer.start();
+        DATA_TYPE min_val = red_min.reduced_data();
+        bench_kernel("MinReduction", hipacc_last_kernel_timing());
+        DATA_TYPE max_val = red_max.reduced_data();
+        bench_kernel("MaxReduction", hipacc_last_kernel_timing());
+        timer.stop();
+        result[0] = min_val;
+        result[1] = max_val;
+    }
+
+    bench_report("minmax", width, height, timer, 6*sizeof(DATA_TYPE));
+
+    bench_dump("minmax", result, 2, 1);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+using namespace hipacc;
+
+
+// Minimum and maximum of every level of a Gaussian pyramid; the coarse levels
+// are reduced without a thread team
+class Downsample : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Mask<float> &mask;
+
+    public:
+        Downsample(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                   Mask<float> &mask)
+            : Kernel(iter), input(input), mask(mask) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> DATA_TYPE {
+                    return mask() * input(mask);
+                });
+        }
+};
+
+
+class MinReduction : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        MinReduction(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = input();
+        }
+
+        DATA_TYPE reduce(DATA_TYPE left, DATA_TYPE right) const {
+            return left < right ? left : right;
+        }
+};
+
+
+class MaxReduction : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+
+    public:
+        MaxReduction(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input)
+            : Kernel(iter), input(input) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            output() = input();
+        }
+
+        DATA_TYPE reduce(DATA_TYPE left, DATA_TYPE right) const {
+            return left > right ? left : right;
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int depth = 8;
+    const float coef[3][3] = {
+        { 0.0625f, 0.125f, 0.0625f },
+        { 0.125f,  0.25f,  0.125f  },
+        { 0.0625f, 0.125f, 0.0625f }
+    };
+
+    // strictly positive, so that a partial result never written reads as a
+    // wrong minimum
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+    for (int i = 0; i < width*height; ++i) host_in[i] += 1;
+
+    Mask<float> mask(coef);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Pyramid<DATA_TYPE> pyr(in, depth);
+
+    DATA_TYPE result[2*depth];
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer.start();
+        traverse(pyr, [&] () {
+            if (!pyr.is_top_level()) {
+                BoundaryCondition<DATA_TYPE> bound(pyr(-1), mask, Boundary::CLAMP);
+                Accessor<DATA_TYPE> acc(bound, Interpolate::NN);
+                IterationSpace<DATA_TYPE> iter(pyr(0));
+                Downsample down(iter, acc, mask);
+                down.execute();
+                bench_kernel("Downsample", hipacc_last_kernel_timing());
+            }
+
+            Accessor<DATA_TYPE> acc(pyr(0));
+            IterationSpace<DATA_TYPE> iter(pyr(0));
+            MinReduction red_min(iter, acc);
+            MaxReduction red_max(iter, acc);
+            result[2*pyr.level()] = red_min.reduced_data();
+            bench_kernel("MinReduction", hipacc_last_kernel_timing());
+            result[2*pyr.level()+1] = red_max.reduced_data();
+            bench_kernel("MaxReduction", hipacc_last_kernel_timing());
+
+            traverse();
+        });
+        timer.stop();
+    }
+
+    bench_report("pyramid_minmax", width, height, timer,
+                 4.0*(2+2)/3*sizeof(DATA_TYPE));
+
+    bench_dump("minmax", result, 2, depth);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+# Runs every benchmark binary once per thread count and collects the JSON
+# lines they print into a single results file.
+#
+# cmake -DBENCH_BINARIES=<bin>,<bin>,... -DBENCH_THREADS=<n>,<n>,...
+#       -DBENCH_ITERATIONS=<n> -DBENCH_RESULTS=<file> -P run_benchmarks.cmake
+
+if(NOT BENCH_BINARIES OR NOT BENCH_RESULTS)
+    message(FATAL_ERROR "BENCH_BINARIES and BENCH_RESULTS have to be set")
+endif()
+if(NOT BENCH_THREADS)
+    set(BENCH_THREADS 1)
+endif()
+if(NOT BENCH_ITERATIONS)
+    set(BENCH_ITERATIONS 10)
+endif()
+
+string(REPLACE "," ";" BENCH_BINARIES "${BENCH_BINARIES}")
+string(REPLACE "," ";" BENCH_THREADS "${BENCH_THREADS}")
+
+file(WRITE ${BENCH_RESULTS} "")
+foreach(binary ${BENCH_BINARIES})
+    foreach(threads ${BENCH_THREADS})
+        execute_process(COMMAND ${CMAKE_COMMAND} -E env OMP_NUM_THREADS=${threads}
+                                                        HIPACC_BENCH_ITERATIONS=${BENCH_ITERATIONS}
+                                                        ${binary}
+                        RESULT_VARIABLE result
+                        OUTPUT_VARIABLE output)
+        if(NOT result EQUAL 0)
+            message(WARNING "${binary} (${threads} threads) failed: ${result}")
+            continue()
+        endif()
+
+        # keep only the result lines, the runtime may print diagnostics
+        string(REPLACE "\n" ";" lines "${output}")
+        foreach(line ${lines})
+            if(line MATCHES "^{\"(benchmark|primitive)\"")
+                message(STATUS "${line}")
+                file(APPEND ${BENCH_RESULTS} "${line}\n")
+            endif()
+        endforeach()
+    endforeach()
+endforeach()
+
+message(STATUS "Benchmark results written to ${BENCH_RESULTS}")
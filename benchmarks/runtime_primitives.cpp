@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Microbenchmarks for the CPU runtime primitives: memory allocation, host
+// transfers with padded strides, region copies, and the reduction and
+// binning templates used by generated code. Bandwidth of every primitive is
+// reported relative to a plain memcpy of the same amount of data.
+
+#include "hipacc_cpu.hpp"
+#include "hipacc_cpu_red.hpp"
+#include "bench.hpp"
+
+#include <cstring>
+#include <string>
+
+
+#define BENCH_SUM(a, b) ((a) + (b))
+
+// reduction and histogram instances for a square image of N x N pixels
+#define BENCH_PRIMITIVES(T, N) \
+    REDUCTION_CPU_2D(sum_ ## T ## _ ## N, T, BENCH_SUM, N, N, 1) \
+    inline void bin_ ## T ## _ ## N ## Put(uint *_lmem, uint _offset, uint idx, uint val); \
+    inline void bin_ ## T ## _ ## N(uint *_lmem, uint _offset, uint num_bins, int x, int y, T pixel) { \
+        bin_ ## T ## _ ## N ## Put(_lmem, _offset, (uint)pixel % num_bins, 1u); \
+    } \
+    BINNING_CPU_2D(hist_ ## T ## _ ## N, T, uint, BENCH_SUM, bin_ ## T ## _ ## N, N, N, 1)
+
+BENCH_PRIMITIVES(float, 1024)
+BENCH_PRIMITIVES(float, 4096)
+BENCH_PRIMITIVES(uchar, 1024)
+BENCH_PRIMITIVES(uchar, 4096)
+
+
+template<typename T> const char *type_name();
+template<> const char *type_name<float>() { return "float"; }
+template<> const char *type_name<uchar>() { return "uchar"; }
+
+
+// bandwidth of memcpy for the given number of bytes, in GB/s
+double memcpy_bandwidth(size_t bytes) {
+    std::vector<char> src(bytes, 1), dst(bytes);
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer.start();
+        std::memcpy(dst.data(), src.data(), bytes);
+        timer.stop();
+    }
+    // memcpy reads and writes every byte
+    return 2.0 * bytes / (timer.median() * 1.0e6);
+}
+
+
+void report(const char *primitive, const char *type, size_t width,
+            size_t height, size_t stride, int threads, const BenchTimer &timer,
+            double bytes, double memcpy_gb_s) {
+    double median = timer.median();
+    double gb_s = median > 0.0 ? bytes / (median * 1.0e6) : 0.0;
+
+    std::printf("{\"primitive\": \"%s\", \"type\": \"%s\", \"width\": %zu, "
+                "\"height\": %zu, \"stride\": %zu, \"threads\": %d, "
+                "\"iterations\": %zu, \"median_ms\": %.4f, \"min_ms\": %.4f, "
+                "\"gb_s\": %.3f, \"memcpy_gb_s\": %.3f, \"efficiency\": %.3f}\n",
+                primitive, type, width, height, stride, threads,
+                timer.iterations(), median, timer.min(), gb_s, memcpy_gb_s,
+                memcpy_gb_s > 0.0 ? gb_s / memcpy_gb_s : 0.0);
+}
+
+
+// hipaccCreateMemory, hipaccWriteMemory, hipaccReadMemory and
+// hipaccCopyMemoryRegion for one image size and alignment
+template<typename T>
+void bench_memory(size_t width, size_t height, size_t alignment) {
+    T *host = bench_input<T>(width, height);
+    double bytes = (double)sizeof(T) * width * height;
+    double memcpy_gb_s = memcpy_bandwidth(sizeof(T) * width * height);
+
+    auto create = [&] () {
+        return alignment ? hipaccCreateMemory<T>(nullptr, width, height, alignment)
+                         : hipaccCreateMemory<T>(nullptr, width, height);
+    };
+
+    BenchTimer timer_create;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer_create.start();
+        HipaccImage img = create();
+        timer_create.stop();
+    }
+
+    HipaccImage img = create();
+    size_t stride = img->stride;
+
+    BenchTimer timer_write, timer_read;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer_write.start();
+        hipaccWriteMemory(img, host);
+        timer_write.stop();
+
+        timer_read.start();
+        hipaccReadMemory<T>(img);
+        timer_read.stop();
+    }
+
+    // interior region, as copied for iteration spaces with offsets
+    size_t border = 16;
+    HipaccImage dst = create();
+    HipaccAccessor acc_src(img, width - 2*border, height - 2*border, border, border);
+    HipaccAccessor acc_dst(dst, width - 2*border, height - 2*border, border, border);
+    double region_bytes = (double)sizeof(T) * acc_src.width * acc_src.height;
+
+    BenchTimer timer_region;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer_region.start();
+        hipaccCopyMemoryRegion(acc_src, acc_dst);
+        timer_region.stop();
+    }
+
+    // traffic is counted like for memcpy (read plus write of each copy):
+    // create and read copy the image once, write copies it to the host
+    // buffer and to the image memory
+    const char *type = type_name<T>();
+    report("hipaccCreateMemory", type, width, height, stride, 1, timer_create, 2*bytes, memcpy_gb_s);
+    report("hipaccWriteMemory", type, width, height, stride, 1, timer_write, 4*bytes, memcpy_gb_s);
+    report("hipaccReadMemory", type, width, height, stride, 1, timer_read, 2*bytes, memcpy_gb_s);
+    report("hipaccCopyMemoryRegion", type, width, height, stride, 1, timer_region, 2*region_bytes, memcpy_gb_s);
+
+    delete[] host;
+}
+
+
+// REDUCTION_CPU_2D and BINNING_CPU_2D instances for one thread count
+template<typename T, int N>
+void bench_reduction(int threads,
+                     T (*reduce)(T[N][N], int, int, int, int, int),
+                     uint *(*binning)(T[N][N], uint, int, int, int, int, int)) {
+    #ifdef _OPENMP
+    omp_set_num_threads(threads);
+    #endif
+
+    T *input = bench_input<T>(N, N);
+    double bytes = (double)sizeof(T) * N * N;
+    // both primitives only read their input
+    double memcpy_gb_s = memcpy_bandwidth(sizeof(T) * N * N) / 2;
+
+    BenchTimer timer_reduce, timer_binning;
+    volatile T sink = 0;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        timer_reduce.start();
+        sink = reduce((T(*)[N])input, N, N, N, 0, 0);
+        timer_reduce.stop();
+
+        timer_binning.start();
+        uint *bins = binning((T(*)[N])input, 256, N, N, N, 0, 0);
+        timer_binning.stop();
+        delete[] bins;
+    }
+    (void)sink;
+
+    const char *type = type_name<T>();
+    report("REDUCTION_CPU_2D", type, N, N, N, threads, timer_reduce, bytes, memcpy_gb_s);
+    report("BINNING_CPU_2D", type, N, N, N, threads, timer_binning, bytes, memcpy_gb_s);
+
+    delete[] input;
+}
+
+
+int main(int argc, const char **argv) {
+    // square power of two images and odd sizes that need padding
+    const size_t sizes[] = { 1000, 1024, 4000, 4096 };
+    const size_t alignments[] = { 0, 256 };
+
+    for (size_t size : sizes) {
+        for (size_t alignment : alignments) {
+            bench_memory<float>(size, size, alignment);
+            bench_memory<uchar>(size, size, alignment);
+        }
+    }
+
+    int max_threads = 1;
+    #ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+    #endif
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        bench_reduction<float, 1024>(threads, sum_float_1024Kernel, hist_float_1024Kernel);
+        bench_reduction<float, 4096>(threads, sum_float_4096Kernel, hist_float_4096Kernel);
+        bench_reduction<uchar, 1024>(threads, sum_uchar_1024Kernel, hist_uchar_1024Kernel);
+        bench_reduction<uchar, 4096>(threads, sum_uchar_4096Kernel, hist_uchar_4096Kernel);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+using namespace hipacc;
+
+
+// Sobel edge detection: gradient magnitude of the 3x3 Sobel derivatives
+class Sobel : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        Mask<int> &mask_x;
+        Mask<int> &mask_y;
+
+    public:
+        Sobel(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+              Mask<int> &mask_x, Mask<int> &mask_y)
+            : Kernel(iter), input(input), mask_x(mask_x), mask_y(mask_y) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            float gx = convolve(mask_x, Reduce::SUM, [&] () -> float {
+                    return mask_x() * input(mask_x);
+                });
+            float gy = convolve(mask_y, Reduce::SUM, [&] () -> float {
+                    return mask_y() * input(mask_y);
+                });
+            output() = (DATA_TYPE)fminf(sqrtf(gx*gx + gy*gy), 255.0f);
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int coef_x[3][3] = {
+        { -1, 0, 1 },
+        { -2, 0, 2 },
+        { -1, 0, 1 }
+    };
+    const int coef_y[3][3] = {
+        { -1, -2, -1 },
+        {  0,  0,  0 },
+        {  1,  2,  1 }
+    };
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Mask<int> mask_x(coef_x);
+    Mask<int> mask_y(coef_y);
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out(width, height);
+    BoundaryCondition<DATA_TYPE> bound(in, mask_x, Boundary::MIRROR);
+    Accessor<DATA_TYPE> acc(bound);
+    IterationSpace<DATA_TYPE> iter(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        Sobel filter(iter, acc, mask_x, mask_y);
+        timer.start();
+        filter.execute();
+        bench_kernel("Sobel", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    bench_report("sobel", width, height, timer, 2*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
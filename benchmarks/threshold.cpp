@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+#include "hipacc.hpp"
+#include "bench.hpp"
+
+#include <limits>
+
+using namespace hipacc;
+
+
+// Point operator with scalar arguments: constant arguments are specialized
+// into the kernel, runtime and non-finite values are passed as parameters
+class Threshold : public Kernel<DATA_TYPE> {
+    private:
+        Accessor<DATA_TYPE> &input;
+        float threshold, scale, upper;
+        int shift;
+
+    public:
+        Threshold(IterationSpace<DATA_TYPE> &iter, Accessor<DATA_TYPE> &input,
+                  float threshold, float scale, float upper, int shift)
+            : Kernel(iter), input(input), threshold(threshold), scale(scale),
+              upper(upper), shift(shift) {
+            add_accessor(&input);
+        }
+
+        void kernel() {
+            float pixel = input();
+            float value = pixel > threshold ? pixel * scale
+                                            : (float)((int)pixel >> shift);
+            output() = (DATA_TYPE)fminf(value, upper);
+        }
+};
+
+
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const float threshold = 127.5f;
+    const float upper = std::numeric_limits<float>::infinity();
+    const int shift = 1;
+    // not known at compile time
+    float scale = argc > 1 ? 0.5f : 1.0f;
+
+    DATA_TYPE *host_in = bench_input<DATA_TYPE>(width, height);
+
+    Image<DATA_TYPE> in(width, height, host_in);
+    Image<DATA_TYPE> out(width, height);
+    Accessor<DATA_TYPE> acc(in);
+    IterationSpace<DATA_TYPE> iter(out);
+
+    BenchTimer timer;
+    for (int i = 0; i < bench_iterations(); ++i) {
+        Threshold filter(iter, acc, threshold, scale, upper, shift);
+        timer.start();
+        filter.execute();
+        bench_kernel("Threshold", hipacc_last_kernel_timing());
+        timer.stop();
+    }
+
+    bench_report("threshold", width, height, timer, 2*sizeof(DATA_TYPE));
+
+    bench_dump("out", out.data(), width, height);
+
+    delete[] host_in;
+    return EXIT_SUCCESS;
+}
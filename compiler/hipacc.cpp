@@ -33,7 +33,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "hipacc.h"
+#include "hipacc/Config/CompileReport.h"
 #include "hipacc/Config/CompilerOptions.h"
+#include "hipacc/Config/TimeReport.h"
 #include "hipacc/Device/TargetDescription.h"
 #include "hipacc/Rewrite/Rewrite.h"
 
@@ -41,10 +43,30 @@
 #include <clang/Driver/Driver.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendActions.h>
 #include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
-
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/StringSaver.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
 
 using namespace clang;
 using namespace hipacc;
@@ -60,8 +82,8 @@ void printCopyright() {
 }
 
 
-void printUsage() {
-  llvm::errs() << "OVERVIEW: Hipacc - Heterogeneous Image Processing Acceleration framework\n\n"
+void printUsage(llvm::raw_ostream &OS=llvm::errs()) {
+  OS << "OVERVIEW: Hipacc - Heterogeneous Image Processing Acceleration framework\n\n"
     << "USAGE:  hipacc [options] <input>\n\n"
     << "OPTIONS:\n\n"
     << "  -emit-cpu               Emit C++ code\n"
@@ -85,11 +107,16 @@ void printUsage() {
     << "                          Code names for for OpenCL on Intel Xeon Phi devices are:\n"
     << "                            'KnightsCorner' for Knights Corner Many Integrated Cores architecture.\n"
     << "  -explore-config         Emit code that explores all possible kernel configuration and print its performance\n"
+    << "                            For CPU, the best configuration is stored in the tuning database (HIPACC_TUNING_DB)\n"
     << "  -use-config <nxm>       Emit code that uses a configuration of nxm threads, e.g. 128x1\n"
     << "  -reduce-config <nxm>    Emit code that uses a multi-dimensional reduction configuration of\n"
     << "                            n warps per block    (affects block size and shared memory size)\n"
     << "                            m partial histograms (affects number of blocks)\n"
     << "  -time-kernels           Emit code that executes each kernel multiple times to get accurate timings\n"
+    << "  -jit                    Emit C/C++ code that compiles each kernel in-process at first launch, specialized for the\n"
+    << "                            actual image sizes, mask values, and host CPU (HIPACC_JIT_CACHE_DIR caches machine code)\n"
+    << "  -multi-device           Emit OpenCL code whose kernels can be split by rows across several devices\n"
+    << "                            at run time (HIPACC_CL_MULTI_DEVICE=1); reductions run on the first device\n"
     << "  -use-textures <o>       Enable/disable usage of textures (cached) in CUDA/OpenCL to read/write image pixels - for GPU devices only\n"
     << "                          Valid values for CUDA on NVIDIA devices: 'off', 'Linear1D', 'Linear2D', 'Array2D', and 'Ldg'\n"
     << "                          Valid values for OpenCL: 'off' and 'Array2D'\n"
@@ -99,7 +126,17 @@ void printUsage() {
     << "                          Valid values: 'on' and 'off'\n"
     << "  -pixels-per-thread <n>  Specify how many pixels should be calculated per thread\n"
     << "  -rs-package <string>    Specify Renderscript package name. (default: \"org.hipacc.rs\")\n"
+    << "  -time-report            Print wall time and peak memory per compiler phase and kernel\n"
+    << "  -time-report-json <file> Write the time report as JSON to <file>\n"
+    << "  -report=<file>.json     Write the code generation decisions of all kernels as JSON to <file>.json\n"
+    << "  -report-remarks <file>  Add the host compiler's vectorization remarks from <file> to the report\n"
+    << "                            (Clang optimization record, -Rpass=loop-vectorize or -fopt-info-vec output)\n"
+    << "  -pch-dir <dir>          Store the precompiled DSL header in <dir> (default: $XDG_CACHE_HOME/hipacc or ~/.cache/hipacc)\n"
+    << "  -no-pch                 Parse the DSL headers from source instead of using a precompiled header\n"
     << "  -o <file>               Write output to <file>\n"
+    << "  -batch <file>           Compile all inputs listed in <file> in one process, one '<input> [options]' per line\n"
+    << "  -compile-commands <file> Compile all hipacc invocations of the compilation database <file>\n"
+    << "  -j <n>                  Use <n> threads in batch mode (default: number of cores)\n"
     << "  --help                  Display available options\n"
     << "  --version               Display version information\n";
 }
@@ -111,15 +148,158 @@ void printVersion() {
 }
 
 
-/// entry to our framework
-int main(int argc, char *argv[]) {
-  // first, print the Copyright notice
-  printCopyright();
+/// locate the DSL header in the user include paths
+std::string findDSLHeader(const HeaderSearchOptions &HSOpts) {
+  for (auto &Entry : HSOpts.UserEntries) {
+    SmallString<256> header(Entry.Path);
+    llvm::sys::path::append(header, "hipacc.hpp");
+    if (llvm::sys::fs::exists(header))
+      return header.str();
+  }
+  return "";
+}
+
+
+/// name of the precompiled header: depends on the compiler invocation and on
+/// the content of all DSL headers, so that any change results in a new PCH
+std::string getDSLHeaderPCH(const CompilerInvocation &Invocation,
+    StringRef header, StringRef pch_dir) {
+  llvm::MD5 Hash;
+  Hash.update(Invocation.getModuleHash());
+  Hash.update(HIPACC_VERSION " " GIT_VERSION);
+
+  std::vector<std::string> files;
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator
+       it(llvm::sys::path::parent_path(header), EC), end;
+       it != end && !EC; it.increment(EC)) {
+    if (llvm::sys::path::extension(it->path()) == ".hpp")
+      files.push_back(it->path());
+  }
+  std::sort(files.begin(), files.end());
+  for (auto &file : files) {
+    auto Buffer = llvm::MemoryBuffer::getFile(file);
+    if (!Buffer)
+      return "";
+    Hash.update(llvm::sys::path::filename(file));
+    Hash.update((*Buffer)->getBuffer());
+  }
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  // default to a per-user cache: the name of the PCH is predictable, in a
+  // shared directory like /tmp any other user could plant it
+  SmallString<256> pch(pch_dir);
+  if (pch.empty()) {
+    if (!llvm::sys::path::user_cache_directory(pch, "hipacc"))
+      return "";
+    if (llvm::sys::fs::create_directories(pch, true,
+                                          llvm::sys::fs::perms::owner_all))
+      return "";
+  }
+  llvm::sys::path::append(pch, "hipacc-" + Result.digest().str() + ".pch");
+  return pch.str();
+}
+
+
+/// an existing precompiled header is only used if the current user created
+/// it, also when -pch-dir points to a shared directory
+bool isOwnDSLHeaderPCH(StringRef pch) {
+#ifdef _WIN32
+  return true;
+#else
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(pch, Status))
+    return false;
+  return Status.getUser() == getuid();
+#endif
+}
+
+
+/// build the precompiled header using the flags of the actual invocation
+bool buildDSLHeaderPCH(const CompilerInvocation &Invocation, StringRef header,
+    StringRef pch, llvm::raw_ostream &OS) {
+  auto PCHInvocation = std::make_shared<CompilerInvocation>(Invocation);
+  FrontendOptions &FrontendOpts = PCHInvocation->getFrontendOpts();
+  FrontendOpts.Inputs.clear();
+  FrontendOpts.Inputs.emplace_back(header, InputKind::CXX);
+  FrontendOpts.OutputFile = pch;
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+
+  CompilerInstance Compiler;
+  Compiler.setInvocation(std::move(PCHInvocation));
+  Compiler.createDiagnostics(
+      new TextDiagnosticPrinter(OS, &Compiler.getDiagnosticOpts()));
+  if (!Compiler.hasDiagnostics())
+    return false;
+
+  GeneratePCHAction PCHAction;
+  return Compiler.ExecuteAction(PCHAction) && llvm::sys::fs::exists(pch);
+}
+
+
+/// command line and settings for compiling a single input file
+struct CompileJob {
+  // hipacc command line and the directory it is executed in
+  std::vector<std::string> cmd_line;
+  std::string directory;
 
   // argument list for Driver after removing our compiler flags
   SmallVector<const char *, 16> args;
-  CompilerOptions compilerOptions = CompilerOptions();
-  std::string out;
+  CompilerOptions compilerOptions;
+  std::string out, pch_dir;
+  bool use_pch = true;
+
+  // compile time measurements per phase and kernel
+  bool time_report = false;
+  std::string time_report_json;
+  TimeReport report;
+
+  // code generation decisions per kernel
+  std::string report_file;
+  std::vector<std::string> remarks_files;
+  CompileReport compile_report;
+
+  // diagnostics of the job: buffered in batch mode and printed at once when
+  // the job is done, so that the output of concurrent jobs does not interleave
+  bool buffer_diagnostics = false;
+  std::string diagnostics;
+  llvm::raw_string_ostream diagnostics_os{diagnostics};
+
+  llvm::raw_ostream &errs() {
+    if (buffer_diagnostics)
+      return diagnostics_os;
+    return llvm::errs();
+  }
+
+  void flushDiagnostics() {
+    if (!buffer_diagnostics)
+      return;
+    static std::mutex errs_mutex;
+    std::lock_guard<std::mutex> lock(errs_mutex);
+    llvm::errs() << diagnostics_os.str();
+    diagnostics.clear();
+  }
+};
+
+// return value of parseOptions() if compilation should proceed
+#define CONTINUE_COMPILATION -1
+
+
+/// parse the command line of a job and check the resulting compiler options,
+/// returns CONTINUE_COMPILATION or the exit code if hipacc is done
+int parseOptions(CompileJob &job) {
+  SmallVector<const char *, 16> &args = job.args;
+  CompilerOptions &compilerOptions = job.compilerOptions;
+  std::string &out = job.out;
+  std::string &pch_dir = job.pch_dir;
+  bool &use_pch = job.use_pch;
+
+  std::vector<const char *> argv;
+  for (auto &arg : job.cmd_line)
+    argv.push_back(arg.c_str());
+  int argc = argv.size();
 
   // parse command line options
   for (int i=0; i<argc; ++i) {
@@ -138,6 +318,7 @@ int main(int argc, char *argv[]) {
     }
     if (StringRef(argv[i]) == "-emit-opencl-cpu") {
       compilerOptions.setTargetLang(Language::OpenCLCPU);
+      compilerOptions.setTargetDevice(Device::CPU);
       continue;
     }
     if (StringRef(argv[i]) == "-emit-opencl-gpu") {
@@ -159,8 +340,8 @@ int main(int argc, char *argv[]) {
       int val;
       buffer >> val;
       if (buffer.fail()) {
-        llvm::errs() << "ERROR: Expected alignment in bytes for -emit-padding switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected alignment in bytes for -emit-padding switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       compilerOptions.setPadding(val);
@@ -175,7 +356,7 @@ int main(int argc, char *argv[]) {
           !compilerOptions.emitOpenCLGPU() &&
           !compilerOptions.emitRenderscript() &&
           !compilerOptions.emitFilterscript()) {
-        llvm::errs() << "WARNING: Setting target is only supported for GPU code generation.\n\n";
+        job.errs() << "WARNING: Setting target is only supported for GPU code generation.\n\n";
         continue;
       }
 
@@ -206,8 +387,8 @@ int main(int argc, char *argv[]) {
       } else if (StringRef(argv[i+1]) == "KnightsCorner") {
         compilerOptions.setTargetDevice(Device::KnightsCorner);
       } else {
-        llvm::errs() << "ERROR: Expected valid code name specification for -target switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid code name specification for -target switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       ++i;
@@ -222,8 +403,8 @@ int main(int argc, char *argv[]) {
       int x=0, y=0, ret=0;
       ret = sscanf(argv[i+1], "%dx%d", &x, &y);
       if (ret!=2) {
-        llvm::errs() << "ERROR: Expected valid configuration specification for -use-config switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid configuration specification for -use-config switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       compilerOptions.setKernelConfig(x, y);
@@ -235,8 +416,8 @@ int main(int argc, char *argv[]) {
       int num_warps=0, num_hists=0, ret=0;
       ret = sscanf(argv[i+1], "%dx%d", &num_warps, &num_hists);
       if (ret!=2) {
-        llvm::errs() << "ERROR: Expected valid configuration specification for -use-config switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid configuration specification for -use-config switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       compilerOptions.setReduceConfig(num_warps, num_hists);
@@ -247,6 +428,14 @@ int main(int argc, char *argv[]) {
       compilerOptions.setTimeKernels(USER_ON);
       continue;
     }
+    if (StringRef(argv[i]) == "-jit") {
+      compilerOptions.setJITKernels(USER_ON);
+      continue;
+    }
+    if (StringRef(argv[i]) == "-multi-device") {
+      compilerOptions.setMultiDevice(USER_ON);
+      continue;
+    }
     if (StringRef(argv[i]) == "-use-textures") {
       assert(i<(argc-1) && "Mandatory texture memory specification for -use-textures switch missing.");
       if (StringRef(argv[i+1]) == "off") {
@@ -260,8 +449,8 @@ int main(int argc, char *argv[]) {
       } else if (StringRef(argv[i+1]) == "Ldg") {
         compilerOptions.setTextureMemory(Texture::Ldg);
       } else {
-        llvm::errs() << "ERROR: Expected valid texture memory specification for -use-textures switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid texture memory specification for -use-textures switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       ++i;
@@ -274,8 +463,8 @@ int main(int argc, char *argv[]) {
       } else if (StringRef(argv[i+1]) == "on") {
         compilerOptions.setLocalMemory(USER_ON);
       } else {
-        llvm::errs() << "ERROR: Expected valid local memory specification for -use-local switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid local memory specification for -use-local switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       ++i;
@@ -288,8 +477,8 @@ int main(int argc, char *argv[]) {
       } else if (StringRef(argv[i+1]) == "on") {
         compilerOptions.setVectorizeKernels(USER_ON);
       } else {
-        llvm::errs() << "ERROR: Expected valid vectorization specification for -use-vectorize switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected valid vectorization specification for -use-vectorize switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       ++i;
@@ -301,8 +490,8 @@ int main(int argc, char *argv[]) {
       int val;
       buffer >> val;
       if (buffer.fail()) {
-        llvm::errs() << "ERROR: Expected integer parameter for -pixels-per-thread switch.\n\n";
-        printUsage();
+        job.errs() << "ERROR: Expected integer parameter for -pixels-per-thread switch.\n\n";
+        printUsage(job.errs());
         return EXIT_FAILURE;
       }
       compilerOptions.setPixelsPerThread(val);
@@ -315,8 +504,36 @@ int main(int argc, char *argv[]) {
       ++i;
       continue;
     }
+    if (StringRef(argv[i]) == "-pch-dir") {
+      assert(i<(argc-1) && "Mandatory directory for -pch-dir switch missing.");
+      pch_dir = argv[++i];
+      continue;
+    }
+    if (StringRef(argv[i]) == "-no-pch") {
+      use_pch = false;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-time-report") {
+      job.time_report = true;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-time-report-json") {
+      assert(i<(argc-1) && "Mandatory file name for -time-report-json switch missing.");
+      job.time_report = true;
+      job.time_report_json = argv[++i];
+      continue;
+    }
+    if (StringRef(argv[i]).startswith("-report=")) {
+      job.report_file = StringRef(argv[i]).split('=').second.str();
+      continue;
+    }
+    if (StringRef(argv[i]) == "-report-remarks") {
+      assert(i<(argc-1) && "Mandatory file name for -report-remarks switch missing.");
+      job.remarks_files.push_back(argv[++i]);
+      continue;
+    }
     if (StringRef(argv[i]) == "-help" || StringRef(argv[i]) == "--help") {
-      printUsage();
+      printUsage(job.errs());
       return EXIT_SUCCESS;
     }
     if (StringRef(argv[i]) == "-version" || StringRef(argv[i]) == "--version") {
@@ -343,51 +560,57 @@ int main(int argc, char *argv[]) {
 
   // CUDA supported only on NVIDIA devices
   if (compilerOptions.emitCUDA() && !targetDevice.isNVIDIAGPU()) {
-    llvm::errs() << "ERROR: CUDA code generation selected, but no CUDA-capable target device specified!\n"
-                 << "  Please select correct target device/code generation back end combination.\n\n";
-    printUsage();
+    job.errs() << "ERROR: CUDA code generation selected, but no CUDA-capable target device specified!\n"
+               << "  Please select correct target device/code generation back end combination.\n\n";
+    printUsage(job.errs());
     return EXIT_FAILURE;
   }
   // OpenCL (GPU) only supported on GPU devices
   if (compilerOptions.emitOpenCLGPU() &&
       !(targetDevice.isAMDGPU() || targetDevice.isARMGPU() ||
         targetDevice.isNVIDIAGPU())) {
-    llvm::errs() << "ERROR: OpenCL (GPU) code generation selected, but no OpenCL-capable GPU target device specified!\n"
-                 << "  Please select correct target device/code generation back end combination.\n\n";
-    printUsage();
+    job.errs() << "ERROR: OpenCL (GPU) code generation selected, but no OpenCL-capable GPU target device specified!\n"
+               << "  Please select correct target device/code generation back end combination.\n\n";
+    printUsage(job.errs());
     return EXIT_FAILURE;
   }
   // OpenCL (ACC) only supported on accelerator devices
   if (compilerOptions.emitOpenCLACC() && !targetDevice.isINTELACC()) {
-    llvm::errs() << "ERROR: OpenCL (ACC) code generation selected, but no OpenCL-capable accelerator device specified!\n"
-                 << "  Please select correct target device/code generation back end combination.\n\n";
-    printUsage();
+    job.errs() << "ERROR: OpenCL (ACC) code generation selected, but no OpenCL-capable accelerator device specified!\n"
+               << "  Please select correct target device/code generation back end combination.\n\n";
+    printUsage(job.errs());
     return EXIT_FAILURE;
   }
   // Textures in CUDA - Ldg (load via texture cache) was introduced with Kepler
   if (compilerOptions.emitCUDA() && compilerOptions.useTextureMemory(USER_ON)) {
     if (compilerOptions.getTextureType()==Texture::Ldg &&
         compilerOptions.getTargetDevice() < Device::Kepler_35) {
-      llvm::errs() << "Warning: 'Ldg' texture memory only supported for Kepler and later on (CC >= 3.5)!"
-                   << "  Using 'Linear1D' instead!\n";
+      job.errs() << "Warning: 'Ldg' texture memory only supported for Kepler and later on (CC >= 3.5)!"
+                 << "  Using 'Linear1D' instead!\n";
       compilerOptions.setTextureMemory(Texture::Linear1D);
     }
   }
   // Textures in OpenCL - only supported on some CPU platforms
   if (compilerOptions.emitOpenCLCPU() && compilerOptions.useTextureMemory(USER_ON)) {
-      llvm::errs() << "Warning: image support is only available on some CPU devices!\n";
+      job.errs() << "Warning: image support is only available on some CPU devices!\n";
+  }
+  // No local memory staging on CPUs - caches serve the neighborhood
+  if (compilerOptions.emitOpenCLCPU() && compilerOptions.useLocalMemory(USER_ON)) {
+    job.errs() << "Warning: local memory does not pay off on CPU devices!\n"
+               << "  Local memory disabled!\n";
+    compilerOptions.setLocalMemory(USER_OFF);
   }
   // Textures in OpenCL - only supported on GPU & some CPU platforms
   if (compilerOptions.emitOpenCLACC() && compilerOptions.useTextureMemory(USER_ON)) {
-      llvm::errs() << "ERROR: image support is not available on ACC devices!\n\n";
-      printUsage();
+      job.errs() << "ERROR: image support is not available on ACC devices!\n\n";
+      printUsage(job.errs());
       return EXIT_FAILURE;
   }
   // Textures in OpenCL - only Array2D textures supported
   if (compilerOptions.emitOpenCLGPU() && compilerOptions.useTextureMemory(USER_ON)) {
     if (compilerOptions.getTextureType()!=Texture::Array2D) {
-      llvm::errs() << "Warning: 'Linear1D', 'Linear2D', and 'Ldg' texture memory not supported by OpenCL!\n"
-                   << "  Using 'Array2D' instead!\n";
+      job.errs() << "Warning: 'Linear1D', 'Linear2D', and 'Ldg' texture memory not supported by OpenCL!\n"
+                 << "  Using 'Array2D' instead!\n";
       compilerOptions.setTextureMemory(Texture::Array2D);
     }
   }
@@ -395,27 +618,54 @@ int main(int argc, char *argv[]) {
   if (compilerOptions.useKernelConfig(USER_ON) && !compilerOptions.emitC99()) {
     if (compilerOptions.getKernelConfigX()*compilerOptions.getKernelConfigY() >
         (int)targetDevice.max_threads_per_block) {
-      llvm::errs() << "ERROR: Invalid kernel configuration: maximum threads for target device are "
-                   << targetDevice.max_threads_per_block << "!\n\n";
-      printUsage();
+      job.errs() << "ERROR: Invalid kernel configuration: maximum threads for target device are "
+                 << targetDevice.max_threads_per_block << "!\n\n";
+      printUsage(job.errs());
       return EXIT_FAILURE;
     }
   }
   // Pixels per thread > 1 not supported on Filterscript
   if (compilerOptions.emitFilterscript() &&
       compilerOptions.getPixelsPerThread() > 1) {
-    llvm::errs() << "Warning: computing multiple pixels per thread is not supported by Filterscript!\n"
-                 << "  Computing only a single pixel per thread instead!\n";
+    job.errs() << "Warning: computing multiple pixels per thread is not supported by Filterscript!\n"
+               << "  Computing only a single pixel per thread instead!\n";
     compilerOptions.setPixelsPerThread(1);
   }
   // No scratchpad memory support in Renderscript/Filterscript
   if (compilerOptions.emitFilterscript() || compilerOptions.emitRenderscript()) {
     if (compilerOptions.useLocalMemory(USER_ON)) {
-      llvm::errs() << "Warning: local memory support is not available in Renderscript and Filterscript!\n"
-                   << "  Local memory disabled!\n";
+      job.errs() << "Warning: local memory support is not available in Renderscript and Filterscript!\n"
+                 << "  Local memory disabled!\n";
     }
     compilerOptions.setLocalMemory(USER_OFF);
   }
+  // JIT compilation is only supported for C/C++ kernels
+  if (compilerOptions.jitKernels(USER_ON) && !compilerOptions.emitC99()) {
+    job.errs() << "ERROR: JIT compilation of kernels requires C/C++ code generation (-emit-c99)!\n\n";
+    printUsage(job.errs());
+    return EXIT_FAILURE;
+  }
+  // explored kernels process tiles of the iteration space and are compiled
+  // ahead of time
+  if (compilerOptions.jitKernels(USER_ON) &&
+      compilerOptions.exploreConfig(USER_ON)) {
+    job.errs() << "Warning: exploration of kernel configurations is not supported for JIT compiled kernels!\n"
+               << "  JIT compilation disabled!\n";
+    compilerOptions.setJITKernels(USER_OFF);
+  }
+  // only OpenCL kernels can be split across devices, explored kernels are
+  // launched by the runtime on a single device
+  if (compilerOptions.multiDevice(USER_ON) && !compilerOptions.emitOpenCL()) {
+    job.errs() << "Warning: splitting kernels across multiple devices is only supported for OpenCL!\n"
+               << "  Multi-device code disabled!\n";
+    compilerOptions.setMultiDevice(USER_OFF);
+  }
+  if (compilerOptions.multiDevice(USER_ON) &&
+      compilerOptions.exploreConfig(USER_ON)) {
+    job.errs() << "Warning: splitting kernels across multiple devices is not supported for explored kernels!\n"
+               << "  Multi-device code disabled!\n";
+    compilerOptions.setMultiDevice(USER_OFF);
+  }
   if (compilerOptions.timeKernels(USER_ON) &&
       compilerOptions.exploreConfig(USER_ON)) {
     // kernels are timed internally by the runtime in case of exploration
@@ -423,12 +673,27 @@ int main(int argc, char *argv[]) {
   }
 
   // print summary of compiler options
-  compilerOptions.printSummary(targetDevice.getTargetDeviceName());
+  compilerOptions.printSummary(targetDevice.getTargetDeviceName(), job.errs());
+  if (!job.report_file.empty()) {
+    job.compile_report.setOptions(
+        compilerOptions.getReport(targetDevice.getTargetDeviceName()));
+    for (auto &file : job.remarks_files)
+      if (!job.compile_report.readRemarks(file))
+        job.errs() << "Warning: could not read vectorization remarks '"
+                   << file << "'!\n";
+  }
+
+  return CONTINUE_COMPILATION;
+}
 
 
+/// translate the input file of a job
+int translateJob(CompileJob &job, TimeReport *report) {
+  SmallVector<const char *, 16> &args = job.args;
+
   // use the Driver (from Tooling.cpp)
   IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
-  TextDiagnosticPrinter DiagnosticPrinter(llvm::errs(), &*DiagOpts);
+  TextDiagnosticPrinter DiagnosticPrinter(job.errs(), &*DiagOpts);
   DiagnosticsEngine Diagnostics(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs()),
       &*DiagOpts, &DiagnosticPrinter, false);
@@ -453,16 +718,45 @@ int main(int argc, char *argv[]) {
   Invocation->getCodeGenOpts().DisableFree = false;
   Invocation->getDependencyOutputOpts() = DependencyOutputOptions();
 
+  // parse the DSL headers only once and reuse them as precompiled header
+  if (job.use_pch) {
+    // jobs of a batch share the PCH, only one of them builds it
+    static std::mutex pch_mutex;
+    std::lock_guard<std::mutex> lock(pch_mutex);
+    TimeReport::Region Time(report, "Precompiled header");
+
+    std::string header = findDSLHeader(Invocation->getHeaderSearchOpts());
+    std::string pch;
+    if (!header.empty())
+      pch = getDSLHeaderPCH(*Invocation, header, job.pch_dir);
+    if (!pch.empty() && llvm::sys::fs::exists(pch) &&
+        !isOwnDSLHeaderPCH(pch)) {
+      job.errs() << "Warning: precompiled header '" << pch
+                 << "' belongs to another user, parsing the DSL headers instead!\n";
+      pch.clear();
+    }
+    if (!pch.empty() && !llvm::sys::fs::exists(pch) &&
+        !buildDSLHeaderPCH(*Invocation, header, pch, job.errs())) {
+      job.errs() << "Warning: could not build precompiled header '" << pch
+                 << "' for the DSL headers!\n";
+      pch.clear();
+    }
+    if (!pch.empty())
+      Invocation->getPreprocessorOpts().ImplicitPCHInclude = pch;
+  }
+
   // create a compiler instance to handle the actual work
   CompilerInstance Compiler;
   Compiler.setInvocation(std::move(Invocation));
 
   // create the action for Hipacc
   std::unique_ptr<ASTFrontendAction> HipaccAction(
-      new HipaccRewriteAction(compilerOptions, out));
+      new HipaccRewriteAction(job.compilerOptions, job.out, report,
+        job.report_file.empty() ? nullptr : &job.compile_report));
 
   // create the compiler's actual diagnostics engine.
-  Compiler.createDiagnostics();
+  Compiler.createDiagnostics(
+      new TextDiagnosticPrinter(job.errs(), &Compiler.getDiagnosticOpts()));
   if (!Compiler.hasDiagnostics())
     return EXIT_FAILURE;
 
@@ -470,5 +764,242 @@ int main(int argc, char *argv[]) {
   return !Compiler.ExecuteAction(*HipaccAction);
 }
 
+
+/// translate the input file of a job and report the compile time if requested
+int compileJob(CompileJob &job) {
+  TimeReport *report = job.time_report ? &job.report : nullptr;
+
+  int ret;
+  {
+    TimeReport::Region Time(report, "Total");
+    ret = translateJob(job, report);
+  }
+
+  if (!job.report_file.empty()) {
+    if (std::error_code EC = job.compile_report.write(job.report_file)) {
+      job.errs() << "ERROR: Could not write report '" << job.report_file
+                 << "': " << EC.message() << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!report)
+    return ret;
+
+  if (job.time_report_json.empty()) {
+    report->print(job.errs());
+  } else {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(job.time_report_json, EC, llvm::sys::fs::F_Text);
+    if (EC) {
+      job.errs() << "ERROR: Could not write time report '"
+                 << job.time_report_json << "': " << EC.message() << "\n";
+      return EXIT_FAILURE;
+    }
+    report->printJSON(OS);
+  }
+
+  return ret;
+}
+
+
+/// read a batch file: each line holds the input file and the options specific
+/// to it, e.g. '<input> -o <output>'; these are appended to the command line
+bool readBatchFile(StringRef file, const CompileJob &base,
+    std::vector<std::unique_ptr<CompileJob>> &jobs) {
+  auto Buffer = llvm::MemoryBuffer::getFile(file);
+  if (!Buffer) {
+    llvm::errs() << "ERROR: Could not read batch file '" << file << "'!\n";
+    return false;
+  }
+
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', -1, false);
+  for (auto Line : Lines) {
+    Line = Line.trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    llvm::BumpPtrAllocator Alloc;
+    llvm::StringSaver Saver(Alloc);
+    SmallVector<const char *, 16> tokens;
+    llvm::cl::TokenizeGNUCommandLine(Line, Saver, tokens);
+
+    auto job = llvm::make_unique<CompileJob>();
+    job->cmd_line = base.cmd_line;
+    job->cmd_line.insert(job->cmd_line.end(), tokens.begin(), tokens.end());
+    jobs.push_back(std::move(job));
+  }
+
+  return true;
+}
+
+
+/// read a compilation database: entries invoking hipacc are added as jobs and
+/// executed in their working directory
+bool readCompileCommands(StringRef file,
+    std::vector<std::unique_ptr<CompileJob>> &jobs) {
+  auto Buffer = llvm::MemoryBuffer::getFile(file);
+  if (!Buffer) {
+    llvm::errs() << "ERROR: Could not read compilation database '" << file
+                 << "'!\n";
+    return false;
+  }
+
+  auto Database = llvm::json::parse((*Buffer)->getBuffer());
+  if (!Database || !Database->getAsArray()) {
+    llvm::consumeError(Database.takeError());
+    llvm::errs() << "ERROR: Invalid compilation database '" << file << "'!\n";
+    return false;
+  }
+
+  for (auto &Value : *Database->getAsArray()) {
+    auto Entry = Value.getAsObject();
+    if (!Entry)
+      continue;
+
+    std::vector<std::string> cmd_line;
+    if (auto Arguments = Entry->getArray("arguments")) {
+      for (auto &Argument : *Arguments)
+        if (auto Str = Argument.getAsString())
+          cmd_line.push_back(*Str);
+    } else if (auto Command = Entry->getString("command")) {
+      llvm::BumpPtrAllocator Alloc;
+      llvm::StringSaver Saver(Alloc);
+      SmallVector<const char *, 16> tokens;
+      llvm::cl::TokenizeGNUCommandLine(*Command, Saver, tokens);
+      cmd_line.assign(tokens.begin(), tokens.end());
+    }
+
+    // skip host compiler invocations
+    if (cmd_line.empty() ||
+        !llvm::sys::path::stem(cmd_line[0]).startswith("hipacc"))
+      continue;
+
+    auto job = llvm::make_unique<CompileJob>();
+    job->cmd_line = std::move(cmd_line);
+    if (auto Directory = Entry->getString("directory"))
+      job->directory = *Directory;
+    jobs.push_back(std::move(job));
+  }
+
+  return true;
+}
+
+
+/// compile all jobs of a batch using a thread pool, jobs of the same working
+/// directory are processed together
+int runBatch(std::vector<std::unique_ptr<CompileJob>> &jobs,
+    unsigned num_threads) {
+  SmallString<256> cwd;
+  if (llvm::sys::fs::current_path(cwd)) {
+    llvm::errs() << "ERROR: Could not determine working directory!\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> directories;
+  for (auto &job : jobs)
+    if (std::find(directories.begin(), directories.end(), job->directory) ==
+        directories.end())
+      directories.push_back(job->directory);
+
+  llvm::ThreadPool Pool(num_threads ? num_threads :
+                                      llvm::hardware_concurrency());
+  std::atomic<unsigned> num_failed(0);
+  for (auto &directory : directories) {
+    if (!directory.empty() && llvm::sys::fs::set_current_path(directory)) {
+      llvm::errs() << "ERROR: Could not change to directory '" << directory
+                   << "'!\n";
+      return EXIT_FAILURE;
+    }
+
+    for (auto &job : jobs) {
+      if (job->directory != directory)
+        continue;
+
+      // options are parsed in order, the diagnostics of each job are
+      // printed together once it is done
+      job->buffer_diagnostics = true;
+      int ret = parseOptions(*job);
+      if (ret != CONTINUE_COMPILATION) {
+        job->flushDiagnostics();
+        if (ret != EXIT_SUCCESS)
+          ++num_failed;
+        continue;
+      }
+
+      CompileJob *cur_job = job.get();
+      Pool.async([cur_job, &num_failed] {
+        if (compileJob(*cur_job) != EXIT_SUCCESS)
+          ++num_failed;
+        cur_job->flushDiagnostics();
+      });
+    }
+    Pool.wait();
+
+    if (!directory.empty())
+      llvm::sys::fs::set_current_path(cwd);
+  }
+
+  if (num_failed) {
+    llvm::errs() << "ERROR: " << num_failed << " of " << jobs.size()
+                 << " inputs failed to compile!\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+/// entry to our framework
+int main(int argc, char *argv[]) {
+  // first, print the Copyright notice
+  printCopyright();
+
+  // separate batch mode options from the options shared by all inputs
+  CompileJob base;
+  std::string batch_file, compile_commands;
+  unsigned num_threads = 0;
+  for (int i=0; i<argc; ++i) {
+    if (StringRef(argv[i]) == "-batch") {
+      assert(i<(argc-1) && "Mandatory file name for -batch switch missing.");
+      batch_file = argv[++i];
+      continue;
+    }
+    if (StringRef(argv[i]) == "-compile-commands") {
+      assert(i<(argc-1) && "Mandatory file name for -compile-commands switch missing.");
+      compile_commands = argv[++i];
+      continue;
+    }
+    if (StringRef(argv[i]) == "-j") {
+      assert(i<(argc-1) && "Mandatory integer parameter for -j switch missing.");
+      if (StringRef(argv[i+1]).getAsInteger(10, num_threads)) {
+        llvm::errs() << "ERROR: Expected integer parameter for -j switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    base.cmd_line.push_back(argv[i]);
+  }
+
+  // single input file
+  if (batch_file.empty() && compile_commands.empty()) {
+    int ret = parseOptions(base);
+    if (ret != CONTINUE_COMPILATION)
+      return ret;
+    return compileJob(base);
+  }
+
+  std::vector<std::unique_ptr<CompileJob>> jobs;
+  if (!batch_file.empty() && !readBatchFile(batch_file, base, jobs))
+    return EXIT_FAILURE;
+  if (!compile_commands.empty() && !readCompileCommands(compile_commands, jobs))
+    return EXIT_FAILURE;
+
+  return runBatch(jobs, num_threads);
+}
+
 // vim: set ts=2 sw=2 sts=2 et ai:
 
@@ -103,6 +103,8 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
 
     DeclRefExpr *bh_start_left, *bh_start_right, *bh_start_top,
                 *bh_start_bottom, *bh_fall_back;
+    // tile of the iteration space processed by a C99 kernel call (exploration)
+    DeclRefExpr *tile_start_x, *tile_end_x, *tile_start_y, *tile_end_y;
     DeclRefExpr *outputImage;
     DeclRefExpr *retValRef;
     Expr *writeImageRHS;
@@ -257,6 +259,10 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       Kernel->setUsed(Acc->getOffsetYDecl()->getNameInfo().getAsString());
       return Acc->getOffsetYDecl();
     }
+    DeclRefExpr *getBandYDecl(HipaccAccessor *Acc) {
+      Kernel->setUsed(Acc->getBandYDecl()->getNameInfo().getAsString());
+      return Acc->getBandYDecl();
+    }
     DeclRefExpr *getBHStartLeft() {
       Kernel->setUsed(bh_start_left->getNameInfo().getAsString());
       return bh_start_left;
@@ -323,6 +329,7 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     Expr *addGlobalOffsetY(Expr *idx_y, HipaccAccessor *Acc);
     Expr *removeISOffsetX(Expr *idx_x);
     Expr *removeISOffsetY(Expr *idx_y);
+    Expr *removeBandOffsetY(Expr *idx_y, HipaccAccessor *Acc);
     Expr *accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc, MemoryAccess mem_acc,
         Expr *offset_x=nullptr, Expr *offset_y=nullptr);
     Expr *accessMem2DAt(DeclRefExpr *LHS, Expr *idx_x, Expr *idx_y);
@@ -396,6 +403,10 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       bh_start_top(nullptr),
       bh_start_bottom(nullptr),
       bh_fall_back(nullptr),
+      tile_start_x(nullptr),
+      tile_end_x(nullptr),
+      tile_start_y(nullptr),
+      tile_end_y(nullptr),
       outputImage(nullptr),
       retValRef(nullptr),
       writeImageRHS(nullptr),
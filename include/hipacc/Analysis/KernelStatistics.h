@@ -42,6 +42,7 @@
 #include "hipacc/DSL/CompilerKnownClasses.h"
 
 #include <clang/Analysis/AnalysisDeclContext.h>
+#include <llvm/Support/JSON.h>
 
 namespace clang {
 namespace hipacc {
@@ -69,6 +70,17 @@ enum VectorInfo {
   PROPAGATE   = 0x2
 };
 
+// operation and memory access counts of a kernel; the lambda_* counts are the
+// share of the totals within convolve/reduce/iterate lambda-functions, which
+// are executed once per Mask or Domain element
+struct KernelOpCounts {
+  unsigned ops, sops;
+  unsigned img_loads, img_stores;
+  unsigned mask_loads;
+  unsigned lambda_ops, lambda_sops;
+  unsigned lambda_img_loads, lambda_mask_loads;
+};
+
 class KernelStatistics : public ManagedAnalysis {
   private:
     explicit KernelStatistics(void *impl);
@@ -79,6 +91,9 @@ class KernelStatistics : public ManagedAnalysis {
     MemoryPattern getMemPattern(const FieldDecl *FD);
     VectorInfo getVectorizeInfo(const VarDecl *VD);
     KernelType getKernelType();
+    KernelOpCounts getOpCounts();
+    // kernel type, operation counts, memory patterns and vectorization info
+    llvm::json::Object getReport();
 
     ~KernelStatistics() override;
 
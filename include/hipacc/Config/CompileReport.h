@@ -0,0 +1,230 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+//===--- CompileReport.h - Machine-readable report of kernel decisions ----===//
+//
+// This collects the code generation decisions for each kernel together with
+// the vectorization remarks of the host compiler and writes them as JSON.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef _COMPILE_REPORT_H_
+#define _COMPILE_REPORT_H_
+
+#include <clang/Basic/LLVM.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Regex.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/YAMLParser.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace hipacc {
+
+class CompileReport {
+  private:
+    struct Remark {
+      std::string kind, pass, function, file, message;
+      unsigned line, column;
+    };
+
+    llvm::json::Object options;
+    std::vector<llvm::json::Object> kernels;
+    std::vector<Remark> remarks;
+
+    static bool isVectorizationRemark(const Remark &R) {
+      if (!R.pass.empty())
+        return R.pass == "loop-vectorize" || R.pass == "slp-vectorizer";
+      return StringRef(R.message).contains("vectoriz");
+    }
+
+    static std::string getScalar(llvm::yaml::Node *N) {
+      SmallString<64> storage;
+      if (auto SN = dyn_cast_or_null<llvm::yaml::ScalarNode>(N))
+        return SN->getValue(storage).str();
+      return "";
+    }
+
+    static void readDebugLoc(llvm::yaml::Node *N, Remark &R) {
+      auto MN = dyn_cast_or_null<llvm::yaml::MappingNode>(N);
+      if (!MN)
+        return;
+      for (auto &KV : *MN) {
+        std::string key = getScalar(KV.getKey());
+        std::string value = getScalar(KV.getValue());
+        if (key == "File")   R.file = value;
+        if (key == "Line")   StringRef(value).getAsInteger(10, R.line);
+        if (key == "Column") StringRef(value).getAsInteger(10, R.column);
+      }
+    }
+
+    // optimization record of Clang (-fsave-optimization-record)
+    void readYAMLRemarks(StringRef buffer) {
+      llvm::SourceMgr SM;
+      llvm::yaml::Stream Stream(buffer, SM);
+      for (auto &Doc : Stream) {
+        auto Root = dyn_cast_or_null<llvm::yaml::MappingNode>(Doc.getRoot());
+        if (!Root)
+          continue;
+
+        Remark R = { Root->getRawTag().ltrim('!').str(), "", "", "", "", 0, 0 };
+        for (auto &KV : *Root) {
+          std::string key = getScalar(KV.getKey());
+          if (key == "Pass")     R.pass = getScalar(KV.getValue());
+          if (key == "Function") R.function = getScalar(KV.getValue());
+          if (key == "DebugLoc") readDebugLoc(KV.getValue(), R);
+          if (key != "Args")
+            continue;
+
+          auto Args = dyn_cast_or_null<llvm::yaml::SequenceNode>(KV.getValue());
+          if (!Args)
+            continue;
+          for (auto &Arg : *Args) {
+            auto MN = dyn_cast<llvm::yaml::MappingNode>(&Arg);
+            if (!MN)
+              continue;
+            for (auto &ArgKV : *MN)
+              if (getScalar(ArgKV.getKey()) != "DebugLoc")
+                R.message += getScalar(ArgKV.getValue());
+          }
+        }
+        if (isVectorizationRemark(R))
+          remarks.push_back(R);
+      }
+    }
+
+    // diagnostics of Clang (-Rpass=loop-vectorize) or GCC (-fopt-info-vec)
+    void readTextRemarks(StringRef buffer) {
+      llvm::Regex Diag("^(.+):([0-9]+):([0-9]+): ([a-z ]+): (.*)$");
+      llvm::Regex Pass("\\[-R[a-z-]*=([a-z-]+)\\]$");
+      SmallVector<StringRef, 64> Lines;
+      buffer.split(Lines, '\n', -1, false);
+      for (auto Line : Lines) {
+        SmallVector<StringRef, 6> Matches;
+        if (!Diag.match(Line.rtrim(), &Matches))
+          continue;
+
+        Remark R = { Matches[4].str(), "", "", Matches[1].str(), "", 0, 0 };
+        Matches[2].getAsInteger(10, R.line);
+        Matches[3].getAsInteger(10, R.column);
+        StringRef message = Matches[5];
+        SmallVector<StringRef, 2> PassMatches;
+        if (Pass.match(message, &PassMatches)) {
+          R.pass = PassMatches[1].str();
+          message = message.drop_back(PassMatches[0].size()).rtrim();
+        }
+        R.message = message.str();
+        if (isVectorizationRemark(R))
+          remarks.push_back(R);
+      }
+    }
+
+    // plain name of the function of a remark: demangled for C++ functions
+    // and without the suffix of outlined OpenMP regions (e.g. ._omp_fn.0)
+    static StringRef getFunctionName(StringRef function) {
+      StringRef name = function;
+      unsigned length;
+      if (name.consume_front("_Z") && !name.consumeInteger(10, length) &&
+          length <= name.size())
+        return name.take_front(length);
+      return function.split('.').first;
+    }
+
+    // remarks of the kernel function or of its kernel file
+    llvm::json::Array getRemarks(StringRef kernel, StringRef file) {
+      llvm::json::Array result;
+      for (auto &R : remarks) {
+        bool match = !R.function.empty() &&
+                     getFunctionName(R.function) == kernel;
+        if (!R.file.empty() && llvm::sys::path::stem(R.file) == file)
+          match = true;
+        if (!match)
+          continue;
+        result.push_back(llvm::json::Object{
+            { "kind", R.kind },
+            { "pass", R.pass },
+            { "line", R.line },
+            { "column", R.column },
+            { "message", R.message } });
+      }
+      return result;
+    }
+
+  public:
+    void setOptions(llvm::json::Object opts) { options = std::move(opts); }
+    void addKernel(llvm::json::Object kernel) {
+      kernels.push_back(std::move(kernel));
+    }
+
+    bool readRemarks(StringRef file) {
+      auto Buffer = llvm::MemoryBuffer::getFile(file);
+      if (!Buffer)
+        return false;
+      StringRef buffer = (*Buffer)->getBuffer();
+      if (buffer.ltrim().startswith("---"))
+        readYAMLRemarks(buffer);
+      else
+        readTextRemarks(buffer);
+      return true;
+    }
+
+    std::error_code write(StringRef file) {
+      llvm::json::Array kernel_reports;
+      for (auto &kernel : kernels) {
+        llvm::json::Object report(kernel);
+        StringRef name, file_name;
+        if (auto str = kernel.getString("kernel")) name = *str;
+        if (auto str = kernel.getString("file")) file_name = *str;
+        report["vectorization_remarks"] = getRemarks(name, file_name);
+        kernel_reports.push_back(std::move(report));
+      }
+
+      std::error_code EC;
+      llvm::raw_fd_ostream OS(file, EC, llvm::sys::fs::F_Text);
+      if (EC)
+        return EC;
+      llvm::json::Object report{
+        { "options", llvm::json::Object(options) },
+        { "kernels", std::move(kernel_reports) } };
+      OS << llvm::formatv("{0:2}", llvm::json::Value(std::move(report)))
+         << "\n";
+      return EC;
+    }
+};
+
+} // namespace hipacc
+} // namespace clang
+
+#endif  // _COMPILE_REPORT_H_
+
+// vim: set ts=2 sw=2 sts=2 et ai:
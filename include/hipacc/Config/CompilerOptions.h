@@ -37,6 +37,7 @@
 #include "hipacc/Device/TargetDevices.h"
 
 #include <clang/Basic/Version.h>
+#include <llvm/Support/JSON.h>
 #include <llvm/Support/raw_ostream.h>
 
 #include <string>
@@ -76,6 +77,8 @@ class CompilerOptions {
     // target code features
     CompilerOption explore_config;
     CompilerOption time_kernels;
+    CompilerOption jit_kernels;
+    CompilerOption multi_device;
     // target code features - may be selected by the framework
     CompilerOption kernel_config;
     CompilerOption reduce_config;
@@ -92,23 +95,24 @@ class CompilerOptions {
     Texture texture_type;
     std::string rs_package_name, rs_directory;
 
-    void getOptionAsString(CompilerOption option, int val=-1) {
+    void getOptionAsString(llvm::raw_ostream &OS, CompilerOption option,
+        int val=-1) {
       switch (option) {
         case USER_ON:
-          llvm::errs() << "USER - ENABLED";
-          if (val!=-1) llvm::errs() << " with value '" << val << "'";
+          OS << "USER - ENABLED";
+          if (val!=-1) OS << " with value '" << val << "'";
           break;
         case USER_OFF:
-          llvm::errs() << "USER - DISABLED";
+          OS << "USER - DISABLED";
           break;
         case AUTO:
-          llvm::errs() << "AUTO - determined by the framework";
+          OS << "AUTO - determined by the framework";
           break;
         case ON:
-          llvm::errs() << "ENABLED";
+          OS << "ENABLED";
           break;
         case OFF:
-          llvm::errs() << "DISABLED";
+          OS << "DISABLED";
           break;
       }
     }
@@ -119,6 +123,8 @@ class CompilerOptions {
       target_device(Device::Kepler_30),
       explore_config(OFF),
       time_kernels(OFF),
+      jit_kernels(OFF),
+      multi_device(OFF),
       kernel_config(AUTO),
       reduce_config(AUTO),
       align_memory(AUTO),
@@ -162,6 +168,12 @@ class CompilerOptions {
     bool timeKernels(CompilerOption option=option_ou) {
       return time_kernels & option;
     }
+    bool jitKernels(CompilerOption option=option_ou) {
+      return jit_kernels & option;
+    }
+    bool multiDevice(CompilerOption option=option_ou) {
+      return multi_device & option;
+    }
     bool useKernelConfig(CompilerOption option=option_ou) {
       return kernel_config & option;
     }
@@ -205,6 +217,8 @@ class CompilerOptions {
     void setTargetDevice(Device td) { target_device = td; }
     void setExploreConfig(CompilerOption o) { explore_config = o; }
     void setTimeKernels(CompilerOption o) { time_kernels = o; }
+    void setJITKernels(CompilerOption o) { jit_kernels = o; }
+    void setMultiDevice(CompilerOption o) { multi_device = o; }
     void setLocalMemory(CompilerOption o) { local_memory = o; }
     void setVectorizeKernels(CompilerOption o) { vectorize_kernels = o; }
 
@@ -256,55 +270,101 @@ class CompilerOptions {
       }
     }
 
-    void printSummary(std::string target_device) {
-      llvm::errs() << "HIPACC compiler configuration summary: \n";
-      llvm::errs() << "  Generating target code for '";
+    void printSummary(std::string target_device,
+        llvm::raw_ostream &OS=llvm::errs()) {
+      OS << "HIPACC compiler configuration summary: \n";
+      OS << "  Generating target code for '";
       switch (target_lang) {
-        case Language::C99:          llvm::errs() << "C/C++";        break;
-        case Language::CUDA:         llvm::errs() << "CUDA";         break;
-        case Language::OpenCLACC:    llvm::errs() << "OpenCL (ACC)"; break;
-        case Language::OpenCLCPU:    llvm::errs() << "OpenCL (CPU)"; break;
-        case Language::OpenCLGPU:    llvm::errs() << "OpenCL (GPU)"; break;
-        case Language::Renderscript: llvm::errs() << "Renderscript"; break;
-        case Language::Filterscript: llvm::errs() << "Filterscript"; break;
+        case Language::C99:          OS << "C/C++";        break;
+        case Language::CUDA:         OS << "CUDA";         break;
+        case Language::OpenCLACC:    OS << "OpenCL (ACC)"; break;
+        case Language::OpenCLCPU:    OS << "OpenCL (CPU)"; break;
+        case Language::OpenCLGPU:    OS << "OpenCL (GPU)"; break;
+        case Language::Renderscript: OS << "Renderscript"; break;
+        case Language::Filterscript: OS << "Filterscript"; break;
       }
-      llvm::errs() << "' language.\n";
-      llvm::errs() << "  Target device is '" << target_device << "'";
-
-      llvm::errs() << "\n  Exploration of kernel configurations: ";
-      getOptionAsString(explore_config);
-      llvm::errs() << "\n  Automatic timing of kernel executions: ";
-      getOptionAsString(time_kernels);
-
-      llvm::errs() << "\n  Kernel execution configuration: ";
-      getOptionAsString(kernel_config);
+      OS << "' language.\n";
+      OS << "  Target device is '" << target_device << "'";
+
+      OS << "\n  Exploration of kernel configurations: ";
+      getOptionAsString(OS, explore_config);
+      OS << "\n  Automatic timing of kernel executions: ";
+      getOptionAsString(OS, time_kernels);
+      OS << "\n  JIT compilation of kernels at first launch: ";
+      getOptionAsString(OS, jit_kernels);
+      OS << "\n  Splitting kernels across multiple devices: ";
+      getOptionAsString(OS, multi_device);
+
+      OS << "\n  Kernel execution configuration: ";
+      getOptionAsString(OS, kernel_config);
       if (useKernelConfig()) {
-        llvm::errs() << ": " << kernel_config_x << "x" << kernel_config_y;
+        OS << ": " << kernel_config_x << "x" << kernel_config_y;
       }
-      llvm::errs() << "\n  Multi-dimension reduction configuration: ";
-      getOptionAsString(kernel_config);
+      OS << "\n  Multi-dimension reduction configuration: ";
+      getOptionAsString(OS, kernel_config);
       if (useReduceConfig()) {
-        llvm::errs() << ": " << reduce_config_num_warps << " warps"
+        OS << ": " << reduce_config_num_warps << " warps"
                      << ", " << reduce_config_num_hists << " histograms";
       }
-      llvm::errs() << "\n  Alignment of image memory: ";
-      getOptionAsString(align_memory, align_bytes);
-      llvm::errs() << "\n  Usage of texture memory for images: ";
-      getOptionAsString(texture_memory);
+      OS << "\n  Alignment of image memory: ";
+      getOptionAsString(OS, align_memory, align_bytes);
+      OS << "\n  Usage of texture memory for images: ";
+      getOptionAsString(OS, texture_memory);
       switch (texture_type) {
         case Texture::None:                                    break;
-        case Texture::Linear1D:  llvm::errs() << ": Linear1D"; break;
-        case Texture::Linear2D:  llvm::errs() << ": Linear2D"; break;
-        case Texture::Array2D:   llvm::errs() << ": Array2D";  break;
-        case Texture::Ldg:       llvm::errs() << ": Ldg";      break;
+        case Texture::Linear1D:  OS << ": Linear1D"; break;
+        case Texture::Linear2D:  OS << ": Linear2D"; break;
+        case Texture::Array2D:   OS << ": Array2D";  break;
+        case Texture::Ldg:       OS << ": Ldg";      break;
+      }
+      OS << "\n  Usage of local memory reading from images: ";
+      getOptionAsString(OS, local_memory);
+      OS << "\n  Mapping multiple pixels to one thread: ";
+      getOptionAsString(OS, multiple_pixels, pixels_per_thread);
+      OS << "\n  Vectorization of kernels: ";
+      getOptionAsString(OS, vectorize_kernels);
+      OS << "\n\n";
+    }
+
+    llvm::json::Object getReport(std::string target_device) {
+      auto option = [](CompilerOption option) -> std::string {
+        switch (option) {
+          case USER_ON:  return "USER_ON";
+          case USER_OFF: return "USER_OFF";
+          case AUTO:     return "AUTO";
+          case ON:       return "ON";
+          case OFF:      return "OFF";
+        }
+        return "";
+      };
+      std::string lang;
+      switch (target_lang) {
+        case Language::C99:          lang = "C/C++";        break;
+        case Language::CUDA:         lang = "CUDA";         break;
+        case Language::OpenCLACC:    lang = "OpenCL (ACC)"; break;
+        case Language::OpenCLCPU:    lang = "OpenCL (CPU)"; break;
+        case Language::OpenCLGPU:    lang = "OpenCL (GPU)"; break;
+        case Language::Renderscript: lang = "Renderscript"; break;
+        case Language::Filterscript: lang = "Filterscript"; break;
       }
-      llvm::errs() << "\n  Usage of local memory reading from images: ";
-      getOptionAsString(local_memory);
-      llvm::errs() << "\n  Mapping multiple pixels to one thread: ";
-      getOptionAsString(multiple_pixels, pixels_per_thread);
-      llvm::errs() << "\n  Vectorization of kernels: ";
-      getOptionAsString(vectorize_kernels);
-      llvm::errs() << "\n\n";
+      return llvm::json::Object{
+        { "language", lang },
+        { "target_device", target_device },
+        { "explore_config", option(explore_config) },
+        { "time_kernels", option(time_kernels) },
+        { "jit_kernels", option(jit_kernels) },
+        { "multi_device", option(multi_device) },
+        { "kernel_config", option(kernel_config) },
+        { "kernel_config_size", llvm::json::Array{ kernel_config_x,
+                                                   kernel_config_y } },
+        { "reduce_config", option(reduce_config) },
+        { "align_memory", option(align_memory) },
+        { "align_bytes", align_bytes },
+        { "texture_memory", option(texture_memory) },
+        { "local_memory", option(local_memory) },
+        { "multiple_pixels", option(multiple_pixels) },
+        { "pixels_per_thread", pixels_per_thread },
+        { "vectorize_kernels", option(vectorize_kernels) } };
     }
 };
 } // namespace hipacc
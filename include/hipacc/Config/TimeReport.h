@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+//===--- TimeReport.h - Compile time report per phase and kernel ----------===//
+//
+// This provides wall time, CPU time, and memory measurements of the compiler
+// phases and of each translated kernel.
+//
+// User and system time are those of the calling thread where the platform
+// provides them (Linux), so that concurrent jobs of a batch do not count each
+// other. Resident memory is only available for the whole process: the growth
+// per phase includes allocations of other jobs running at the same time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef _TIME_REPORT_H_
+#define _TIME_REPORT_H_
+
+#include <clang/Basic/LLVM.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace clang {
+namespace hipacc {
+
+class TimeReport {
+  private:
+    struct Times {
+      double wall = 0, user = 0, system = 0;
+    };
+    struct Entry {
+      Times time;
+      // growth of the resident set size (in kB) of the process while running
+      long rss = 0;
+      unsigned count = 0;
+    };
+    struct Running {
+      Times start;
+      long rss;
+    };
+
+    llvm::StringMap<Entry> phases, kernels;
+    llvm::StringMap<Running> running;
+
+    // user and system time are measured per thread where supported
+    static const char *getCPUTimeScope() {
+      #ifdef __linux__
+      return "thread";
+      #else
+      return "process";
+      #endif
+    }
+
+    static Times getCurrentTimes() {
+      llvm::TimeRecord record = llvm::TimeRecord::getCurrentTime();
+      Times times;
+      times.wall = record.getWallTime();
+      times.user = record.getUserTime();
+      times.system = record.getSystemTime();
+      #ifdef __linux__
+      struct rusage usage;
+      if (!getrusage(RUSAGE_THREAD, &usage)) {
+        times.user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+        times.system = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+      }
+      #endif
+      return times;
+    }
+
+    // current resident set size (in kB) of the process
+    static long getCurrentRSS() {
+      #if defined(__linux__)
+      std::ifstream statm("/proc/self/statm");
+      long size, resident;
+      if (!(statm >> size >> resident))
+        return 0;
+      return resident * (sysconf(_SC_PAGESIZE) / 1024);
+      #elif defined(__APPLE__)
+      mach_task_basic_info_data_t info;
+      mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+      if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                    reinterpret_cast<task_info_t>(&info), &count) !=
+          KERN_SUCCESS)
+        return 0;
+      return info.resident_size / 1024;
+      #else
+      return 0;
+      #endif
+    }
+
+    // peak resident set size (in kB) of the process
+    static long getPeakRSS() {
+      #ifdef _WIN32
+      return 0;
+      #else
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage))
+        return 0;
+      #ifdef __APPLE__
+      return usage.ru_maxrss / 1024;
+      #else
+      return usage.ru_maxrss;
+      #endif
+      #endif
+    }
+
+    static std::vector<const llvm::StringMapEntry<Entry> *>
+    sorted(const llvm::StringMap<Entry> &entries) {
+      std::vector<const llvm::StringMapEntry<Entry> *> result;
+      for (auto &entry : entries)
+        result.push_back(&entry);
+      std::sort(result.begin(), result.end(),
+          [](const llvm::StringMapEntry<Entry> *a,
+             const llvm::StringMapEntry<Entry> *b) {
+            if (a->second.time.wall != b->second.time.wall)
+              return a->second.time.wall > b->second.time.wall;
+            return a->getKey() < b->getKey();
+          });
+      return result;
+    }
+
+    static void printTable(llvm::raw_ostream &OS, StringRef title,
+        const llvm::StringMap<Entry> &entries) {
+      if (entries.empty())
+        return;
+      OS << "  " << title << ":\n";
+      OS << "    ---Wall Time---  ---User Time---  --System Time--"
+         << "  Proc. RSS (+kB)  Count  Name\n";
+      for (auto entry : sorted(entries)) {
+        auto &time = entry->second.time;
+        OS << llvm::format("    %15.4f  %15.4f  %15.4f  %15ld  %5u  ",
+                           time.wall, time.user, time.system,
+                           entry->second.rss, entry->second.count)
+           << entry->getKey() << "\n";
+      }
+    }
+
+    static llvm::json::Array toJSON(const llvm::StringMap<Entry> &entries) {
+      llvm::json::Array array;
+      for (auto entry : sorted(entries)) {
+        auto &time = entry->second.time;
+        array.push_back(llvm::json::Object{
+            { "name", entry->getKey() },
+            { "wall", time.wall },
+            { "user", time.user },
+            { "system", time.system },
+            { "process_rss_growth_kb", static_cast<int64_t>(entry->second.rss) },
+            { "count", static_cast<int64_t>(entry->second.count) } });
+      }
+      return array;
+    }
+
+    void start(StringRef key) {
+      running[key] = Running{ getCurrentTimes(), getCurrentRSS() };
+    }
+
+    void stop(StringRef key, llvm::StringMap<Entry> &entries,
+        StringRef name) {
+      auto it = running.find(key);
+      if (it == running.end())
+        return;
+      Times time = getCurrentTimes();
+      Entry &entry = entries[name];
+      entry.time.wall += time.wall - it->second.start.wall;
+      entry.time.user += time.user - it->second.start.user;
+      entry.time.system += time.system - it->second.start.system;
+      entry.rss += getCurrentRSS() - it->second.rss;
+      ++entry.count;
+      running.erase(it);
+    }
+
+  public:
+    // measures a phase or kernel for the lifetime of the object, a null report
+    // disables the measurement
+    class Region {
+      private:
+        TimeReport *report;
+        std::string name;
+        bool kernel;
+
+      public:
+        Region(TimeReport *report, StringRef name, bool kernel=false) :
+          report(report),
+          name(name),
+          kernel(kernel)
+        {
+          if (!report)
+            return;
+          if (kernel)
+            report->startKernel(name);
+          else
+            report->startPhase(name);
+        }
+        ~Region() {
+          if (!report)
+            return;
+          if (kernel)
+            report->stopKernel(name);
+          else
+            report->stopPhase(name);
+        }
+    };
+
+    void startPhase(StringRef name) { start("phase:" + name.str()); }
+    void stopPhase(StringRef name) {
+      stop("phase:" + name.str(), phases, name);
+    }
+    void startKernel(StringRef name) { start("kernel:" + name.str()); }
+    void stopKernel(StringRef name) {
+      stop("kernel:" + name.str(), kernels, name);
+    }
+
+    void print(llvm::raw_ostream &OS) {
+      OS << "HIPACC compile time report (seconds, sorted by wall time, "
+         << "user/system time of the " << getCPUTimeScope()
+         << ", RSS growth of the process):\n";
+      printTable(OS, "Phases", phases);
+      printTable(OS, "Kernels", kernels);
+      OS << "  Process peak RSS: " << getPeakRSS() << " kB\n";
+    }
+
+    void printJSON(llvm::raw_ostream &OS) {
+      llvm::json::Object report{
+        { "phases", toJSON(phases) },
+        { "kernels", toJSON(kernels) },
+        { "cpu_time", getCPUTimeScope() },
+        { "process_peak_rss_kb", static_cast<int64_t>(getPeakRSS()) } };
+      OS << llvm::formatv("{0:2}", llvm::json::Value(std::move(report)))
+         << "\n";
+    }
+};
+
+} // namespace hipacc
+} // namespace clang
+
+#endif  // _TIME_REPORT_H_
+
+// vim: set ts=2 sw=2 sts=2 et ai:
@@ -39,6 +39,7 @@
 #include "hipacc/Device/TargetDescription.h"
 
 #include <clang/AST/ASTContext.h>
+#include <llvm/Support/Format.h>
 
 #include <locale>
 #include <map>
@@ -209,6 +210,8 @@ class HipaccAccessor {
     // kernel parameter name for width, height, and stride
     DeclRefExpr *widthDecl, *heightDecl, *strideDecl, *scaleXDecl, *scaleYDecl;
     DeclRefExpr *offsetXDecl, *offsetYDecl;
+    // first row of the image buffer when the rows are split across devices
+    DeclRefExpr *bandYDecl;
 
   public:
     HipaccAccessor(VarDecl *VD, HipaccBoundaryCondition *bc, Interpolate mode, bool crop) :
@@ -219,7 +222,8 @@ class HipaccAccessor {
       crop(crop),
       widthDecl(nullptr), heightDecl(nullptr), strideDecl(nullptr),
       scaleXDecl(nullptr), scaleYDecl(nullptr),
-      offsetXDecl(nullptr), offsetYDecl(nullptr)
+      offsetXDecl(nullptr), offsetYDecl(nullptr),
+      bandYDecl(nullptr)
     {}
 
     void setWidthDecl(DeclRefExpr *width) { widthDecl = width; }
@@ -229,6 +233,7 @@ class HipaccAccessor {
     void setScaleYDecl(DeclRefExpr *scale) { scaleYDecl = scale; }
     void setOffsetXDecl(DeclRefExpr *ox) { offsetXDecl = ox; }
     void setOffsetYDecl(DeclRefExpr *oy) { offsetYDecl = oy; }
+    void setBandYDecl(DeclRefExpr *by) { bandYDecl = by; }
     VarDecl *getDecl() { return VD; }
     const std::string &getName() const { return name; }
     HipaccBoundaryCondition *getBC() { return bc; }
@@ -245,9 +250,11 @@ class HipaccAccessor {
     DeclRefExpr *getScaleYDecl() { return scaleYDecl; }
     DeclRefExpr *getOffsetXDecl() { return offsetXDecl; }
     DeclRefExpr *getOffsetYDecl() { return offsetYDecl; }
+    DeclRefExpr *getBandYDecl() { return bandYDecl; }
     void resetDecls() {
       widthDecl = heightDecl = strideDecl = nullptr;
       scaleXDecl = scaleYDecl = offsetXDecl = offsetYDecl = nullptr;
+      bandYDecl = nullptr;
     }
     bool isCrop() { return crop; }
     Boundary getBoundaryMode() {
@@ -442,6 +449,9 @@ class HipaccKernelClass {
     KernelType getKernelType() {
       return kernelStatistics->getKernelType();
     }
+    // member is assigned, incremented, or its address is taken within the
+    // kernel, reduce, or binning function
+    bool isMemberModified(FieldDecl *decl);
 
     void addArg(FieldDecl *FD, QualType QT, StringRef Name) {
       KernelMemberInfo info = { FieldKind::Normal, FD, QT, Name };
@@ -575,10 +585,12 @@ class HipaccKernel : public HipaccKernelFeatures {
     std::string kernelName, reduceName, binningName;
     std::string fileName;
     std::string reduceStr, binningStr, infoStr, numBinsStr;
+    std::string sourceHash;
     unsigned infoStrCnt, binningStrCnt;
     HipaccIterationSpace *iterationSpace;
     std::map<FieldDecl *, HipaccAccessor *> imgMap;
     std::map<FieldDecl *, HipaccMask *> maskMap;
+    std::map<FieldDecl *, Expr *> constArgMap;
     SmallVector<QualType, 16> argTypes;
     SmallVector<std::string, 16> argTypeNames;
     SmallVector<std::string, 16> hostArgNames;
@@ -586,11 +598,13 @@ class HipaccKernel : public HipaccKernelFeatures {
     SmallVector<FieldDecl *, 16> deviceArgFields;
     SmallVector<FunctionDecl *, 16> deviceFuncs;
     std::set<std::string> usedVars;
+    std::set<HipaccAccessor *> absoluteAccess;
     unsigned max_threads_for_kernel;
     unsigned max_size_x, max_size_y;
     unsigned max_size_x_undef, max_size_y_undef;
     unsigned num_threads_x, num_threads_y;
     unsigned num_reg, num_lmem, num_smem, num_cmem;
+    unsigned num_border_variants;
 
     void calcSizes();
     void calcConfig();
@@ -615,10 +629,12 @@ class HipaccKernel : public HipaccKernelFeatures {
       binningName(options.getTargetPrefix() + KC->getName() + name + "Binning"),
       fileName(options.getTargetPrefix() + KC->getName() + VD->getNameAsString()),
       reduceStr(), binningStr(), infoStr(), numBinsStr(),
+      sourceHash(),
       infoStrCnt(0), binningStrCnt(0),
       iterationSpace(nullptr),
       imgMap(),
       maskMap(),
+      constArgMap(),
       argTypes(),
       argTypeNames(),
       hostArgNames(),
@@ -633,7 +649,8 @@ class HipaccKernel : public HipaccKernelFeatures {
       num_reg(0),
       num_lmem(0),
       num_smem(0),
-      num_cmem(0)
+      num_cmem(0),
+      num_border_variants(1)
     {
       switch (options.getTargetLang()) {
         default: break;
@@ -659,10 +676,15 @@ class HipaccKernel : public HipaccKernelFeatures {
       return binningStr + "_" + std::to_string(binningStrCnt);
     }
 
+    // hash of the generated kernel source, identifies tuned configurations
+    void setSourceHash(std::string hash) { sourceHash = hash; }
+    const std::string &getSourceHash() const { return sourceHash; }
+
     // keep track of variables used within kernel
     void setUsed(std::string name) { usedVars.insert(name); }
     void resetUsed() {
       usedVars.clear();
+      absoluteAccess.clear();
       deviceFuncs.clear();
       for (auto map : imgMap)
         map.second->resetDecls();
@@ -671,6 +693,17 @@ class HipaccKernel : public HipaccKernelFeatures {
       return usedVars.find(name) != usedVars.end();
     }
 
+    // keep track of images accessed at absolute coordinates (pixel_at() and
+    // output_at()), which may access any row of the image
+    void setAbsoluteAccess(HipaccAccessor *acc) { absoluteAccess.insert(acc); }
+    bool hasAbsoluteAccess(HipaccAccessor *acc) {
+      return absoluteAccess.count(acc);
+    }
+
+    // rows above and below the current row read from an image, -1 if any row
+    // of the image may be read
+    int getBandHalo(HipaccAccessor *acc);
+
     // keep track of functions called within kernel
     void addFunctionCall(FunctionDecl *FD) { deviceFuncs.push_back(FD); }
     ArrayRef<FunctionDecl *> getFunctionCalls() { return deviceFuncs; }
@@ -704,6 +737,16 @@ class HipaccKernel : public HipaccKernelFeatures {
       return iter->second;
     }
 
+    // specialize the kernel for scalar arguments with constant values: their
+    // members are replaced by literals in the kernel body
+    void setConstArgs(ArrayRef<Expr *> hostArgs);
+    Expr *getConstArg(FieldDecl *decl) {
+      auto iter = constArgMap.find(decl);
+      if (iter == constArgMap.end())
+        return nullptr;
+      return iter->second;
+    }
+
     ArrayRef<QualType> getArgTypes() {
       createArgInfo();
       return argTypes;
@@ -753,11 +796,26 @@ class HipaccKernel : public HipaccKernelFeatures {
     }
 
     void setDefaultConfig();
+    void estimateWorkPerPixel(unsigned &ops, unsigned &bytes);
+
+    // number of code variants generated for the image border regions
+    void setNumBorderVariants(unsigned num) { num_border_variants = num; }
+    unsigned getNumBorderVariants() { return num_border_variants; }
+
+    // code generation decisions of the kernel for the compile report
+    llvm::json::Object getReport();
 
     void printStats() {
+      unsigned ops, bytes;
+      estimateWorkPerPixel(ops, bytes);
       llvm::errs() << "Statistics for Kernel '" << fileName << "'\n";
       llvm::errs() << "  Vectorization: " << vectorize() << "\n";
       llvm::errs() << "  Pixels per thread: " << getPixelsPerThread() << "\n";
+      llvm::errs() << "  Operations per pixel: " << ops << "\n";
+      llvm::errs() << "  Bytes per pixel: " << bytes << "\n";
+      llvm::errs() << "  Arithmetic intensity: "
+                   << llvm::format("%.2f", bytes ? (double)ops/bytes : 0.0)
+                   << " ops/byte\n";
 
       for (auto map : memMap) {
         llvm::errs() << "  Image '" << map.first->getName() << "': ";
@@ -39,6 +39,8 @@
 #include <clang/AST/ASTContext.h>
 #include <clang/Basic/Builtins.h>
 
+#include <vector>
+
 namespace clang {
 namespace hipacc {
 namespace Builtin {
@@ -56,7 +58,6 @@ struct Info {
   const char *Name, *Type;
   Language builtin_lang;
   ID CUDA, OpenCL, Renderscript;
-  FunctionDecl *FD;
 
   bool operator==(const Info &RHS) const {
     return !strcmp(Name, RHS.Name) && !strcmp(Type, RHS.Type);
@@ -68,12 +69,16 @@ class Context {
   private:
     ASTContext &Ctx;
     bool initialized;
+    // builtin declarations are created in the ASTContext of this instance,
+    // hence they are not shared between translation units
+    std::vector<FunctionDecl *> builtinDecls;
     const Info &getRecord(unsigned ID) const;
 
   public:
     explicit Context(ASTContext &Ctx) :
       Ctx(Ctx),
-      initialized(false)
+      initialized(false),
+      builtinDecls(LastBuiltin-FirstBuiltin, nullptr)
     {}
 
     QualType getBuiltinType(unsigned Id) const;
@@ -87,7 +92,8 @@ class Context {
     void getBuiltinNames(Language lang, SmallVectorImpl<const char *> &Names);
 
     FunctionDecl *getBuiltinFunction(unsigned ID) const {
-      return getRecord(ID-FirstBuiltin).FD;
+      assert(ID-FirstBuiltin < builtinDecls.size());
+      return builtinDecls[ID-FirstBuiltin];
     }
 
     FunctionDecl *getBuiltinFunction(StringRef Name, QualType QT, Language lang)
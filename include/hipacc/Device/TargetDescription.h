@@ -67,7 +67,24 @@ class HipaccDeviceOptions {
     {
       switch (options.getTargetDevice()) {
         case Device::CPU:
+          // OpenCL on CPUs: one large work-group per core that spans several
+          // rows; staging through local memory only adds copies since the
+          // caches hold the neighborhood anyway
           alignment = 8;
+          if (!options.emitOpenCLCPU())
+            break;
+          alignment = 64;
+          local_memory_threshold = 9999;
+          default_num_threads_x = 256;
+          default_num_threads_y = 4;
+          pixels_per_thread[PointOperator] = 1;
+          pixels_per_thread[LocalOperator] = 1;
+          pixels_per_thread[GlobalOperator] = 16;
+          require_textures[PointOperator] = Texture::None;
+          require_textures[LocalOperator] = Texture::None;
+          require_textures[GlobalOperator] = Texture::None;
+          require_textures[UserOperator] = Texture::None;
+          vectorization = false;
           break;
         case Device::Fermi_20:
         case Device::Fermi_21:
@@ -219,6 +236,13 @@ class HipaccDevice : public HipaccDeviceOptions {
       switch (target_device) {
         case Device::CPU:
           max_threads_per_warp = 1;
+          max_blocks_per_multiprocessor = 1;
+          max_threads_per_block = 1024;
+          max_warps_per_multiprocessor = 1024;
+          max_threads_per_multiprocessor = 1024;
+          max_total_registers = 65536;
+          max_total_shared_memory = 32768;
+          max_register_per_thread = 255;
           break;
         case Device::Fermi_20:
           max_threads_per_block = 1024;
@@ -371,6 +395,13 @@ class HipaccDevice : public HipaccDeviceOptions {
       return RUNTIME_INCLUDES;
     }
 
+    // IEEE semantics for Inf/NaN are kept, hence no -cl-fast-relaxed-math
+    std::string getCLBuildOptions() {
+      if (target_device == Device::CPU)
+        return " -cl-mad-enable -cl-no-signed-zeros";
+      return "";
+    }
+
     unsigned getTargetCC() {
       assert(isNVIDIAGPU() && "compute capability only valid for NVIDIA");
       return static_cast<std::underlying_type<Device>::type>(target_device);
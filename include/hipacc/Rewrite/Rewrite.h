@@ -38,16 +38,23 @@
 
 namespace clang {
 namespace hipacc {
+class CompileReport;
 class CompilerOptions;
+class TimeReport;
 class HipaccRewriteAction : public ASTFrontendAction {
   private:
     CompilerOptions &options;
     std::string out_file;
+    TimeReport *report;
+    CompileReport *compile_report;
 
   public:
-    HipaccRewriteAction(CompilerOptions &options, std::string out_file) :
+    HipaccRewriteAction(CompilerOptions &options, std::string out_file,
+        TimeReport *report=nullptr, CompileReport *compile_report=nullptr) :
       options(options),
-      out_file(out_file)
+      out_file(out_file),
+      report(report),
+      compile_report(compile_report)
     {}
 
   protected:
@@ -164,23 +164,37 @@ T *ASTTranslate::lookup(std::string name, QualType QT, NamespaceDecl *NS) {
 // C/C++ initialization
 void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   VarDecl *gid_x = nullptr, *gid_y = nullptr;
+  Expr *lower_x = nullptr, *lower_y = nullptr;
+
+  // explored kernels process only the tile [tile_start, tile_end) of the
+  // iteration space per call
+  if (tile_start_x && tile_end_x && tile_start_y && tile_end_y) {
+    for (auto tile_var : { tile_start_x, tile_end_x, tile_start_y, tile_end_y })
+      Kernel->setUsed(tile_var->getNameInfo().getAsString());
+    lower_x = tile_start_x;
+    lower_y = tile_start_y;
+  }
 
   // C/C++: int gid_x = offset_x;
   if (Kernel->getIterationSpace()->getOffsetXDecl()) {
-    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy,
-        getOffsetXDecl(Kernel->getIterationSpace()));
+    Expr *offset_x = getOffsetXDecl(Kernel->getIterationSpace());
+    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy, lower_x ?
+        createBinaryOperator(Ctx, offset_x, lower_x, BO_Add, Ctx.IntTy) :
+        offset_x);
   } else {
-    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy,
-        createIntegerLiteral(Ctx, 0));
+    gid_x = createVarDecl(Ctx, kernelDecl, "gid_x", Ctx.IntTy, lower_x ?
+        lower_x : createIntegerLiteral(Ctx, 0));
   }
 
   // C/C++: int gid_y = offset_y;
   if (Kernel->getIterationSpace()->getOffsetYDecl()) {
-    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
-        getOffsetYDecl(Kernel->getIterationSpace()));
+    Expr *offset_y = getOffsetYDecl(Kernel->getIterationSpace());
+    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy, lower_y ?
+        createBinaryOperator(Ctx, offset_y, lower_y, BO_Add, Ctx.IntTy) :
+        offset_y);
   } else {
-    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
-        createIntegerLiteral(Ctx, 0));
+    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy, lower_y ?
+        lower_y : createIntegerLiteral(Ctx, 0));
   }
 
   // add gid_x and gid_y statements
@@ -232,8 +246,8 @@ void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   //     }
   // }
   //
-  Expr *upper_x = getWidthDecl(Kernel->getIterationSpace());
-  Expr *upper_y = getHeightDecl(Kernel->getIterationSpace());
+  Expr *upper_x = lower_x ? tile_end_x : getWidthDecl(Kernel->getIterationSpace());
+  Expr *upper_y = lower_y ? tile_end_y : getHeightDecl(Kernel->getIterationSpace());
   if (Kernel->getIterationSpace()->getOffsetXDecl()) {
     upper_x = createBinaryOperator(Ctx, upper_x,
         getOffsetXDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
@@ -382,6 +396,9 @@ void ASTTranslate::initOpenCL(SmallVector<Stmt *, 16> &kernelBody) {
   //size_t get_group_id(uint dimindx);
   FunctionDecl *get_group_id =
     builtins.getBuiltinFunction(OPENCLBIget_group_id);
+  //size_t get_global_offset(uint dimindx);
+  FunctionDecl *get_global_offset =
+    builtins.getBuiltinFunction(OPENCLBIget_global_offset);
 
   // .(0) .(1)
   SmallVector<Expr *, 16> tmpArg0;
@@ -420,6 +437,17 @@ void ASTTranslate::initOpenCL(SmallVector<Stmt *, 16> &kernelBody) {
   tileVars.block_id_y = createImplicitCastExpr(Ctx, Ctx.getConstType(Ctx.IntTy),
       CK_IntegralCast, createFunctionCall(Ctx, get_group_id, tmpArg1), nullptr,
       VK_RValue);
+  // the runtime splits the rows across devices using a global work offset,
+  // which is not included in get_group_id:
+  // OpenCL: get_group_id(1) + get_global_offset(1)/get_local_size(1)
+  if (compilerOptions.multiDevice()) {
+    tileVars.block_id_y = createParenExpr(Ctx, createBinaryOperator(Ctx,
+          tileVars.block_id_y, createBinaryOperator(Ctx,
+            createImplicitCastExpr(Ctx, Ctx.getConstType(Ctx.IntTy),
+              CK_IntegralCast, createFunctionCall(Ctx, get_global_offset,
+                tmpArg1), nullptr, VK_RValue), tileVars.local_size_y, BO_Div,
+            Ctx.IntTy), BO_Add, Ctx.IntTy));
+  }
   //grid_size_x = createImplicitCastExpr(Ctx, Ctx.getConstType(Ctx.IntTy),
   //    CK_IntegralCast, createFunctionCall(Ctx, get_num_groups, tmpArg0),
   //    nullptr, VK_RValue);
@@ -592,6 +620,24 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
       continue;
     }
 
+    // search for tile parameters of explored C99 kernels
+    if (param->getName().equals("tile_start_x")) {
+      tile_start_x = parm_ref;
+      continue;
+    }
+    if (param->getName().equals("tile_end_x")) {
+      tile_end_x = parm_ref;
+      continue;
+    }
+    if (param->getName().equals("tile_start_y")) {
+      tile_start_y = parm_ref;
+      continue;
+    }
+    if (param->getName().equals("tile_end_y")) {
+      tile_end_y = parm_ref;
+      continue;
+    }
+
     if (compilerOptions.emitRenderscript() ||
         compilerOptions.emitFilterscript()) {
       // search for uint32_t x, uint32_t y parameters
@@ -630,6 +676,10 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
         Acc->setOffsetYDecl(parm_ref);
         continue;
       }
+      if (param->getName().equals(img->getNameAsString() + "_band_y")) {
+        Acc->setBandYDecl(parm_ref);
+        continue;
+      }
     }
   }
 
@@ -1007,6 +1057,8 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
     kernelBody.push_back(GS);
   }
 
+  Kernel->setNumBorderVariants(LDS.size());
+
   // add casts to tileVars if required
   updateTileVars();
 
@@ -1677,6 +1729,11 @@ Expr *ASTTranslate::VisitMemberExprTranslate(MemberExpr *E) {
   ValueDecl *VD = E->getMemberDecl();
   ValueDecl *paramDecl = nullptr;
 
+  // propagate constant arguments the kernel is specialized for
+  if (auto FD = dyn_cast<FieldDecl>(VD))
+    if (Expr *constArg = Kernel->getConstArg(FD))
+      return Clone(constArg);
+
   // search for member name in kernel parameter list
   for (auto param : kernelDecl->parameters()) {
     // parameter name matches
@@ -2198,6 +2255,7 @@ Expr *ASTTranslate::VisitCXXMemberCallExprTranslate(CXXMemberCallExpr *E) {
     Expr *idx_x = addGlobalOffsetX(Clone(E->getArg(0)), acc);
     Expr *idx_y = addGlobalOffsetY(Clone(E->getArg(1)), acc);
     Expr *result = nullptr;
+    Kernel->setAbsoluteAccess(acc);
 
     switch (compilerOptions.getTargetLang()) {
       case Language::C99:
@@ -2216,7 +2274,8 @@ Expr *ASTTranslate::VisitCXXMemberCallExprTranslate(CXXMemberCallExpr *E) {
         if (Kernel->useTextureMemory(acc) != Texture::None) {
           result = accessMemImgAt(LHS, acc, mem_acc, idx_x, idx_y);
         } else {
-          result = accessMemArrAt(LHS, getStrideDecl(acc), idx_x, idx_y);
+          result = accessMemArrAt(LHS, getStrideDecl(acc), idx_x,
+              removeBandOffsetY(idx_y, acc));
         }
         break;
       case Language::Renderscript:
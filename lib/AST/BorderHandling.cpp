@@ -264,7 +264,8 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
           RHS = accessMemImgAt(LHS, Acc, READ_ONLY, idx_x, idx_y);
           break;
         }
-        RHS = accessMemArrAt(LHS, getStrideDecl(Acc), idx_x, idx_y);
+        RHS = accessMemArrAt(LHS, getStrideDecl(Acc), idx_x,
+            removeBandOffsetY(idx_y, Acc));
         break;
       case Language::Renderscript:
       case Language::Filterscript:
@@ -350,7 +351,8 @@ Expr *ASTTranslate::addBorderHandling(DeclRefExpr *LHS, Expr *local_offset_x,
           result = accessMemImgAt(LHS, Acc, READ_ONLY, idx_x, idx_y);
           break;
         }
-        result = accessMemArrAt(LHS, getStrideDecl(Acc), idx_x, idx_y);
+        result = accessMemArrAt(LHS, getStrideDecl(Acc), idx_x,
+            removeBandOffsetY(idx_y, Acc));
         break;
       case Language::Renderscript:
       case Language::Filterscript:
@@ -92,6 +92,17 @@ Expr *ASTTranslate::removeISOffsetY(Expr *idx_y) {
 }
 
 
+// remove first row of the buffer passed for a band of rows
+Expr *ASTTranslate::removeBandOffsetY(Expr *idx_y, HipaccAccessor *Acc) {
+  if (Acc->getBandYDecl()) {
+    idx_y = createBinaryOperator(Ctx, idx_y, getBandYDecl(Acc), BO_Sub,
+        Ctx.IntTy);
+  }
+
+  return idx_y;
+}
+
+
 // access memory
 Expr *ASTTranslate::accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc,
     MemoryAccess mem_acc, Expr *local_offset_x, Expr *local_offset_y) {
@@ -169,7 +180,8 @@ Expr *ASTTranslate::accessMem(DeclRefExpr *LHS, HipaccAccessor *Acc,
         case Language::OpenCLCPU:
         case Language::OpenCLGPU:
           if (Kernel->useTextureMemory(Acc) == Texture::None)
-            return accessMemArrAt(LHS, getStrideDecl(Acc), idx_x, idx_y);
+            return accessMemArrAt(LHS, getStrideDecl(Acc), idx_x,
+                removeBandOffsetY(idx_y, Acc));
           return accessMemImgAt(LHS, Acc, mem_acc, idx_x, idx_y);
         case Language::Renderscript:
         case Language::Filterscript:
@@ -41,6 +41,8 @@
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/StmtVisitor.h>
 
+#include <map>
+
 //#define DEBUG_ANALYSIS
 
 using namespace clang;
@@ -70,6 +72,8 @@ class KernelStatsImpl {
     unsigned num_ops, num_sops;
     unsigned num_img_loads, num_img_stores;
     unsigned num_mask_loads, num_mask_stores;
+    unsigned num_lambda_ops, num_lambda_sops;
+    unsigned num_lambda_img_loads, num_lambda_mask_loads;
     VectorInfo stmtVectorize;
     bool inLambdaFunction;
 
@@ -104,6 +108,10 @@ class KernelStatsImpl {
       num_img_stores(0),
       num_mask_loads(0),
       num_mask_stores(0),
+      num_lambda_ops(0),
+      num_lambda_sops(0),
+      num_lambda_img_loads(0),
+      num_lambda_mask_loads(0),
       stmtVectorize(SCALAR),
       inLambdaFunction(false)
     {}
@@ -243,7 +251,10 @@ void KernelStatsImpl::runOnAllBlocks() {
                << "  image loads: "         << num_img_loads << "\n"
                << "  image stores: "        << num_img_stores << "\n"
                << "  mask loads: "          << num_mask_loads << "\n"
-               << "  mask stores: "         << num_mask_stores << "\n";
+               << "  mask stores: "         << num_mask_stores << "\n"
+               << "  in lambda-functions: "  << num_lambda_ops << " ALU, "
+               << num_lambda_sops << " SFU, " << num_lambda_img_loads
+               << " image loads, " << num_lambda_mask_loads << " mask loads\n";
 
   llvm::errs() << "  images:\n";
   for (auto map : memToPattern) {
@@ -296,6 +307,75 @@ KernelType KernelStatistics::getKernelType() {
 }
 
 
+KernelOpCounts KernelStatistics::getOpCounts() {
+  KernelStatsImpl &KS = getImpl(impl);
+  KernelOpCounts counts = {
+    KS.num_ops, KS.num_sops,
+    KS.num_img_loads, KS.num_img_stores,
+    KS.num_mask_loads,
+    KS.num_lambda_ops, KS.num_lambda_sops,
+    KS.num_lambda_img_loads, KS.num_lambda_mask_loads
+  };
+  return counts;
+}
+
+
+llvm::json::Object KernelStatistics::getReport() {
+  KernelStatsImpl &KS = getImpl(impl);
+
+  std::string type;
+  switch (KS.kernelType) {
+    case PointOperator:   type = "Point Operator";  break;
+    case LocalOperator:   type = "Local Operator";  break;
+    case GlobalOperator:  type = "Global Operator"; break;
+    default:
+    case UserOperator:    type = "Custom Operator"; break;
+  }
+
+  // DenseMaps are ordered by pointer, sort by name for a stable report
+  std::map<std::string, llvm::json::Array> images;
+  for (auto map : KS.memToPattern) {
+    llvm::json::Array patterns;
+    if (map.second == 0)        patterns.push_back("UNDEFINED");
+    if (map.second & NO_STRIDE) patterns.push_back("NO_STRIDE");
+    if (map.second & USER_XY)   patterns.push_back("USER_XY");
+    if (map.second & STRIDE_X)  patterns.push_back("STRIDE_X");
+    if (map.second & STRIDE_Y)  patterns.push_back("STRIDE_Y");
+    if (map.second & STRIDE_XY) patterns.push_back("STRIDE_XY");
+    images[map.first->getNameAsString()] = std::move(patterns);
+  }
+  std::map<std::string, std::string> variables;
+  for (auto map : KS.declsToVector) {
+    switch (map.second) {
+      case SCALAR:    variables[map.first->getName()] = "SCALAR";    break;
+      case VECTORIZE: variables[map.first->getName()] = "VECTORIZE"; break;
+      case PROPAGATE: variables[map.first->getName()] = "PROPAGATE"; break;
+    }
+  }
+
+  llvm::json::Object image_patterns, var_infos;
+  for (auto &image : images)
+    image_patterns[image.first] = std::move(image.second);
+  for (auto &var : variables)
+    var_infos[var.first] = var.second;
+
+  return llvm::json::Object{
+    { "type", type },
+    { "ops_alu", KS.num_ops },
+    { "ops_sfu", KS.num_sops },
+    { "image_loads", KS.num_img_loads },
+    { "image_stores", KS.num_img_stores },
+    { "mask_loads", KS.num_mask_loads },
+    { "mask_stores", KS.num_mask_stores },
+    { "lambda_ops_alu", KS.num_lambda_ops },
+    { "lambda_ops_sfu", KS.num_lambda_sops },
+    { "lambda_image_loads", KS.num_lambda_img_loads },
+    { "lambda_mask_loads", KS.num_lambda_mask_loads },
+    { "memory_patterns", std::move(image_patterns) },
+    { "vectorization", std::move(var_infos) } };
+}
+
+
 MemoryPattern TransferFunctions::checkStride(Expr *EX, Expr *EY) {
   bool stride_x=true, stride_y=true;
 
@@ -707,11 +787,23 @@ void TransferFunctions::VisitLambdaExpr(LambdaExpr *E) {
   AC.getCFG()->viewCFG(KS.Ctx.getLangOpts());
   #endif
 
+  bool nested = KS.inLambdaFunction;
+  unsigned ops = KS.num_ops, sops = KS.num_sops;
+  unsigned img_loads = KS.num_img_loads, mask_loads = KS.num_mask_loads;
+
   KS.inLambdaFunction = true;
   auto POV = AC.getAnalysis<PostOrderCFGView>();
   for (auto block : *POV)
     KS.runOnBlock(block);
-  KS.inLambdaFunction = false;
+  KS.inLambdaFunction = nested;
+
+  // keep track of the share of the outermost lambda-function
+  if (!nested) {
+    KS.num_lambda_ops += KS.num_ops - ops;
+    KS.num_lambda_sops += KS.num_sops - sops;
+    KS.num_lambda_img_loads += KS.num_img_loads - img_loads;
+    KS.num_lambda_mask_loads += KS.num_mask_loads - mask_loads;
+  }
 }
 
 void TransferFunctions::VisitReturnStmt(ReturnStmt *S) {
@@ -33,6 +33,7 @@
 
 #include "hipacc/DSL/ClassRepresentation.h"
 
+#include <clang/AST/RecursiveASTVisitor.h>
 #include <llvm/Support/Format.h>
 
 #ifdef USE_JIT_ESTIMATE
@@ -226,6 +227,145 @@ void HipaccBoundaryCondition::setConstVal(APValue &val, ASTContext &Ctx) {
 }
 
 
+namespace {
+// looks for writes to a member: assignments, increments and decrements, taking
+// its address, and binding it to non-const references
+class MemberWriteVisitor : public RecursiveASTVisitor<MemberWriteVisitor> {
+  private:
+    FieldDecl *FD;
+    bool modified;
+
+    bool refersToMember(Expr *E) {
+      if (auto ME = dyn_cast<MemberExpr>(E->IgnoreParenImpCasts()))
+        return ME->getMemberDecl() == FD;
+      return false;
+    }
+    static bool isNonConstRef(QualType QT) {
+      return QT->isReferenceType() &&
+             !QT.getNonReferenceType().isConstQualified();
+    }
+
+  public:
+    explicit MemberWriteVisitor(FieldDecl *FD) : FD(FD), modified(false) {}
+
+    bool isModified() { return modified; }
+
+    bool VisitBinaryOperator(BinaryOperator *E) {
+      if (E->isAssignmentOp() && refersToMember(E->getLHS()))
+        modified = true;
+      return !modified;
+    }
+    bool VisitUnaryOperator(UnaryOperator *E) {
+      if ((E->isIncrementDecrementOp() || E->getOpcode() == UO_AddrOf) &&
+          refersToMember(E->getSubExpr()))
+        modified = true;
+      return !modified;
+    }
+    bool VisitVarDecl(VarDecl *VD) {
+      if (isNonConstRef(VD->getType()) && VD->getInit() &&
+          refersToMember(VD->getInit()))
+        modified = true;
+      return !modified;
+    }
+    bool VisitCallExpr(CallExpr *E) {
+      auto FD = E->getDirectCallee();
+      if (!FD)
+        return true;
+      for (size_t i=0, e=std::min(E->getNumArgs(), FD->getNumParams()); i<e;
+           ++i) {
+        if (isNonConstRef(FD->getParamDecl(i)->getType()) &&
+            refersToMember(E->getArg(i)))
+          modified = true;
+      }
+      return !modified;
+    }
+};
+}
+
+
+bool HipaccKernelClass::isMemberModified(FieldDecl *decl) {
+  for (auto fun : { kernelFunction, reduceFunction, binningFunction }) {
+    if (!fun || !fun->hasBody())
+      continue;
+    MemberWriteVisitor Visitor(decl);
+    Visitor.TraverseStmt(fun->getBody());
+    if (Visitor.isModified())
+      return true;
+  }
+  return false;
+}
+
+
+void HipaccKernel::setConstArgs(ArrayRef<Expr *> hostArgs) {
+  constArgMap.clear();
+
+  size_t i = 0;
+  for (auto arg : KC->getMembers()) {
+    Expr *hostArg = hostArgs[i++];
+    if (arg.kind != HipaccKernelClass::FieldKind::Normal)
+      continue;
+
+    // only scalar members that are read-only within the kernel
+    QualType QT = arg.type.getCanonicalType().getUnqualified();
+    const BuiltinType *BT = QT->getAs<BuiltinType>();
+    if (!BT || KC->isMemberModified(arg.field))
+      continue;
+
+    Expr::EvalResult result;
+    if (hostArg->isValueDependent() ||
+        !hostArg->EvaluateAsRValue(result, Ctx) || result.HasSideEffects)
+      continue;
+    APValue &val = result.Val;
+
+    Expr *literal = nullptr;
+    if (BT->isInteger() && val.isInt()) {
+      // types narrower than int (including bool) are promoted within
+      // expressions anyway, and literals of these types can't be printed
+      QualType LT;
+      switch (BT->getKind()) {
+        case BuiltinType::Int:
+        case BuiltinType::UInt:
+        case BuiltinType::Long:
+        case BuiltinType::ULong:
+        case BuiltinType::LongLong:
+        case BuiltinType::ULongLong:
+          LT = QT;
+          break;
+        default:
+          if (Ctx.getTypeSize(QT) < Ctx.getTypeSize(Ctx.IntTy))
+            LT = Ctx.IntTy;
+          break;
+      }
+      if (LT.isNull())
+        continue;
+      llvm::APSInt ival = val.getInt();
+      ival = ival.extOrTrunc(Ctx.getTypeSize(QT));
+      ival.setIsSigned(QT->isSignedIntegerType());
+      ival = ival.extOrTrunc(Ctx.getTypeSize(LT));
+      literal = IntegerLiteral::Create(Ctx, ival, LT, SourceLocation());
+    } else if (BT->isFloatingPoint() && (val.isFloat() || val.isInt())) {
+      llvm::APFloat fval(Ctx.getFloatTypeSemantics(QT));
+      bool lost;
+      if (val.isFloat()) {
+        fval = val.getFloat();
+        fval.convert(Ctx.getFloatTypeSemantics(QT),
+            llvm::APFloat::rmNearestTiesToEven, &lost);
+      } else {
+        fval.convertFromAPInt(val.getInt(), val.getInt().isSigned(),
+            llvm::APFloat::rmNearestTiesToEven);
+      }
+      // Inf and NaN have no literal representation
+      if (!fval.isFinite())
+        continue;
+      literal = FloatingLiteral::Create(Ctx, fval, false, QT, SourceLocation());
+    }
+
+    if (literal)
+      constArgMap[arg.field] = literal;
+  }
+}
+
+
 void HipaccKernel::calcSizes() {
   for (auto map : imgMap) {
     // only Accessors with proper border handling mode
@@ -244,6 +384,22 @@ void HipaccKernel::calcSizes() {
 }
 
 
+int HipaccKernel::getBandHalo(HipaccAccessor *acc) {
+  if (acc == iterationSpace)
+    return hasAbsoluteAccess(acc) ? -1 : 0;
+
+  // interpolated, repeated, and absolute accesses may read any row; without
+  // border handling the window size is not known
+  if (acc->getInterpolationMode() != Interpolate::NO ||
+      acc->getBoundaryMode() == Boundary::REPEAT ||
+      (acc->getBoundaryMode() == Boundary::UNDEFINED && !acc->getSizeY()) ||
+      hasAbsoluteAccess(acc))
+    return -1;
+
+  return std::max(acc->getSizeY(), max_size_y_undef) >> 1;
+}
+
+
 struct sortOccMap {
   bool operator()(const std::pair<unsigned, float> &left, const std::pair<unsigned, float> &right) {
     if (left.second < right.second) return false;
@@ -461,6 +617,114 @@ void HipaccKernel::setDefaultConfig() {
   num_threads_y = default_num_threads_y;
 }
 
+// Estimate the work of the kernel per output pixel for a roofline model.
+// Operations within lambda-functions are executed once per element of the
+// largest Mask/Domain, or of the largest Accessor window if there is none.
+// Memory traffic is the compulsory traffic: every image is read or written
+// once per pixel, assuming windows of local operators are served by caches.
+void HipaccKernel::estimateWorkPerPixel(unsigned &ops, unsigned &bytes) {
+  KernelOpCounts counts = KC->getKernelStatistics().getOpCounts();
+
+  unsigned footprint = 0;
+  for (auto map : maskMap)
+    footprint = std::max(footprint,
+        map.second->getSizeX() * map.second->getSizeY());
+  if (!footprint)
+    footprint = std::max(1u, max_size_x_undef * max_size_y_undef);
+
+  unsigned lambda_ops = counts.lambda_ops + counts.lambda_sops;
+  ops = counts.ops + counts.sops - lambda_ops + lambda_ops * footprint;
+
+  bytes = 0;
+  for (auto map : imgMap)
+    bytes += map.second->getImage()->getPixelSize();
+}
+
+llvm::json::Object HipaccKernel::getReport() {
+  unsigned ops, bytes;
+  estimateWorkPerPixel(ops, bytes);
+
+  llvm::json::Array images;
+  for (auto map : imgMap) {
+    HipaccAccessor *Acc = map.second;
+    std::string memory, texture, boundary, interpolation;
+    if (memMap[Acc] & Global)   memory = "global";
+    if (memMap[Acc] & Constant) memory = "constant";
+    if (memMap[Acc] & Texture_) memory = "texture";
+    switch (texMap[Acc]) {
+      case Texture::None:     texture = "None";     break;
+      case Texture::Linear1D: texture = "Linear1D"; break;
+      case Texture::Linear2D: texture = "Linear2D"; break;
+      case Texture::Array2D:  texture = "Array2D";  break;
+      case Texture::Ldg:      texture = "Ldg";      break;
+    }
+    switch (Acc->getBoundaryMode()) {
+      case Boundary::UNDEFINED: boundary = "UNDEFINED"; break;
+      case Boundary::CLAMP:     boundary = "CLAMP";     break;
+      case Boundary::REPEAT:    boundary = "REPEAT";    break;
+      case Boundary::MIRROR:    boundary = "MIRROR";    break;
+      case Boundary::CONSTANT:  boundary = "CONSTANT";  break;
+    }
+    switch (Acc->getInterpolationMode()) {
+      case Interpolate::NO: interpolation = "NO"; break;
+      case Interpolate::NN: interpolation = "NN"; break;
+      case Interpolate::LF: interpolation = "LF"; break;
+      case Interpolate::CF: interpolation = "CF"; break;
+      case Interpolate::L3: interpolation = "L3"; break;
+    }
+    std::string access;
+    switch (KC->getMemAccess(map.first)) {
+      case UNDEFINED:  access = "UNDEFINED";  break;
+      case READ_ONLY:  access = "READ_ONLY";  break;
+      case WRITE_ONLY: access = "WRITE_ONLY"; break;
+      case READ_WRITE: access = "READ_WRITE"; break;
+    }
+    images.push_back(llvm::json::Object{
+        { "name", map.first->getNameAsString() },
+        { "image", Acc->getImage()->getName() },
+        { "access", access },
+        { "memory", memory },
+        { "local_memory", (memMap[Acc] & Local) != 0 },
+        { "texture", texture },
+        { "window", std::to_string(Acc->getSizeX()) + "x" +
+                    std::to_string(Acc->getSizeY()) },
+        { "boundary", boundary },
+        { "interpolation", interpolation } });
+  }
+
+  llvm::json::Array const_args;
+  for (auto arg : KC->getMembers()) {
+    if (auto literal = getConstArg(arg.field)) {
+      std::string value;
+      llvm::raw_string_ostream OS(value);
+      literal->printPretty(OS, 0, PrintingPolicy(Ctx.getLangOpts()));
+      const_args.push_back(llvm::json::Object{
+          { "name", arg.name },
+          { "value", OS.str() } });
+    }
+  }
+
+  return llvm::json::Object{
+    { "name", name },
+    { "kernel", kernelName },
+    { "class", KC->getName() },
+    { "file", fileName },
+    { "statistics", KC->getKernelStatistics().getReport() },
+    { "block_size", llvm::json::Array{ num_threads_x, num_threads_y } },
+    { "pixels_per_thread", getPixelsPerThread() },
+    { "vectorization", vectorize() },
+    { "border_variants", num_border_variants },
+    { "const_args", std::move(const_args) },
+    { "ops_per_pixel", ops },
+    { "bytes_per_pixel", bytes },
+    { "resources", llvm::json::Object{
+        { "registers", num_reg },
+        { "local_memory", num_lmem },
+        { "shared_memory", num_smem },
+        { "constant_memory", num_cmem } } },
+    { "images", std::move(images) } };
+}
+
 void HipaccKernel::addParam(QualType QT1, QualType QT2, QualType QT3,
     std::string typeC, std::string typeO, std::string name, FieldDecl *fd) {
   switch (options.getTargetLang()) {
@@ -530,6 +794,13 @@ void HipaccKernel::createArgInfo() {
               nullptr);
         }
 
+        // band_y: first row of the OpenCL buffer, the runtime passes a
+        // sub-buffer per device when the rows are split across devices
+        if (options.emitOpenCL() && options.multiDevice() &&
+            useTextureMemory(getImgFromMapping(arg.field)) == Texture::None) {
+          addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_band_y", nullptr);
+        }
+
         break;
       case HipaccKernelClass::FieldKind::Mask:
         QTtmp = Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
@@ -568,6 +839,13 @@ void HipaccKernel::createArgInfo() {
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     addParam(Ctx.getConstType(Ctx.IntTy), "bh_fall_back", nullptr);
   }
+  // tile of the iteration space processed by an explored C99 kernel
+  if (options.emitC99() && options.exploreConfig()) {
+    addParam(Ctx.getConstType(Ctx.IntTy), "tile_start_x", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), "tile_end_x", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), "tile_start_y", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), "tile_end_y", nullptr);
+  }
 }
 
 
@@ -622,6 +900,12 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
           hostArgNames.push_back(Acc->getName() + ".offset_y");
         }
 
+        // band_y
+        if (options.emitOpenCL() && options.multiDevice() &&
+            useTextureMemory(Acc) == Texture::None) {
+          hostArgNames.push_back(getInfoStr() + ".band_y");
+        }
+
         break;
         }
       case HipaccKernelClass::FieldKind::Mask:
@@ -649,6 +933,13 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     hostArgNames.push_back(getInfoStr() + ".bh_fall_back");
   }
+  // tile_start_x, tile_end_x, tile_start_y, tile_end_y
+  if (options.emitC99() && options.exploreConfig()) {
+    hostArgNames.push_back("_tile.start_x");
+    hostArgNames.push_back("_tile.end_x");
+    hostArgNames.push_back("_tile.start_y");
+    hostArgNames.push_back("_tile.end_y");
+  }
 }
 
 // vim: set ts=2 sw=2 sts=2 et ai:
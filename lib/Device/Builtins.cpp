@@ -38,12 +38,12 @@ using namespace clang;
 using namespace hipacc;
 using namespace hipacc::Builtin;
 
-static hipacc::Builtin::Info BuiltinInfo[] = {
-  { "not a builtin function", 0, Language::C99, static_cast<ID>(0), static_cast<ID>(0), static_cast<ID>(0), 0 },
-  #define HIPACCBUILTIN(NAME, TYPE, CUDAID, OPENCLID, RSID) { #NAME, TYPE, Language::C99, CUDAID, OPENCLID, RSID, 0 },
-  #define CUDABUILTIN(NAME, TYPE, CUDANAME) { #NAME, TYPE, Language::CUDA, (ID)0, (ID)0, (ID)0, 0 },
-  #define OPENCLBUILTIN(NAME, TYPE, OPENCLNAME) { #NAME, TYPE, Language::OpenCLCPU, (ID)0, (ID)0, (ID)0, 0 },
-  #define RSBUILTIN(NAME, TYPE, RSNAME) { #NAME, TYPE, Language::Renderscript, (ID)0, (ID)0, (ID)0, 0 },
+static const hipacc::Builtin::Info BuiltinInfo[] = {
+  { "not a builtin function", 0, Language::C99, static_cast<ID>(0), static_cast<ID>(0), static_cast<ID>(0) },
+  #define HIPACCBUILTIN(NAME, TYPE, CUDAID, OPENCLID, RSID) { #NAME, TYPE, Language::C99, CUDAID, OPENCLID, RSID },
+  #define CUDABUILTIN(NAME, TYPE, CUDANAME) { #NAME, TYPE, Language::CUDA, (ID)0, (ID)0, (ID)0 },
+  #define OPENCLBUILTIN(NAME, TYPE, OPENCLNAME) { #NAME, TYPE, Language::OpenCLCPU, (ID)0, (ID)0, (ID)0 },
+  #define RSBUILTIN(NAME, TYPE, RSNAME) { #NAME, TYPE, Language::Renderscript, (ID)0, (ID)0, (ID)0 },
   #include "hipacc/Device/Builtins.def"
 };
 
@@ -337,7 +337,7 @@ void hipacc::Builtin::Context::InitializeBuiltins() {
   if (initialized) return;
 
   for (size_t i=1, e=LastBuiltin-FirstBuiltin; i!=e; ++i) {
-    BuiltinInfo[i].FD = CreateBuiltin(i);
+    builtinDecls[i] = CreateBuiltin(i);
   }
 
   initialized = true;
@@ -426,7 +426,7 @@ FunctionDecl *hipacc::Builtin::Context::getBuiltinFunction(StringRef Name,
   QT = QT.getDesugaredType(Ctx);
 
   for (size_t i=1, e=LastBuiltin-FirstBuiltin; i!=e; ++i) {
-    if (BuiltinInfo[i].Name == Name && BuiltinInfo[i].FD->getReturnType() == QT) {
+    if (BuiltinInfo[i].Name == Name && builtinDecls[i]->getReturnType() == QT) {
       switch (BuiltinInfo[i].builtin_lang) {
         case Language::C99:
           switch (lang) {
@@ -443,17 +443,17 @@ FunctionDecl *hipacc::Builtin::Context::getBuiltinFunction(StringRef Name,
           }
           break;
         case Language::CUDA:
-          if (lang == Language::CUDA) return BuiltinInfo[i].FD;
+          if (lang == Language::CUDA) return builtinDecls[i];
         case Language::OpenCLACC:
         case Language::OpenCLCPU:
         case Language::OpenCLGPU:
           if (lang == Language::OpenCLACC ||
               lang == Language::OpenCLCPU ||
-              lang == Language::OpenCLGPU) return BuiltinInfo[i].FD;
+              lang == Language::OpenCLGPU) return builtinDecls[i];
         case Language::Renderscript:
         case Language::Filterscript:
           if (lang == Language::Renderscript ||
-              lang == Language::Filterscript) return BuiltinInfo[i].FD;
+              lang == Language::Filterscript) return builtinDecls[i];
       }
     }
   }
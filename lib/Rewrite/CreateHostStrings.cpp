@@ -41,7 +41,11 @@ using namespace hipacc;
 void CreateHostStrings::writeHeaders(std::string &resultStr) {
   switch (options.getTargetLang()) {
     case Language::C99:
-      resultStr += "#include \"hipacc_cpu_standalone.hpp\"\n\n"; break;
+      resultStr += "#include \"hipacc_cpu_standalone.hpp\"\n";
+      if (options.jitKernels())
+        resultStr += "#include \"hipacc_cpu_jit_standalone.hpp\"\n";
+      resultStr += "\n";
+      break;
     case Language::CUDA:
       resultStr += "#include \"hipacc_cu_standalone.hpp\"\n\n";  break;
     case Language::OpenCLACC:
@@ -89,12 +93,12 @@ void CreateHostStrings::writeInitialization(std::string &resultStr) {
 
 
 void writeCLCompilation(std::string fileName, std::string kernel_name,
-    std::string includes, std::string &resultStr, std::string suffix="") {
+    std::string build_options, std::string &resultStr, std::string suffix="") {
   resultStr += "cl_kernel " + kernel_name + suffix;
   resultStr += " = hipaccBuildProgramAndKernel(";
   resultStr += "\"" + fileName + ".cl\", ";
   resultStr += "\"" + kernel_name + suffix + "\", ";
-  resultStr += "true, false, false, \"-I " + includes + "\");\n";
+  resultStr += "true, false, false, \"" + build_options + "\");\n";
 }
 
 
@@ -117,25 +121,27 @@ void CreateHostStrings::writeKernelCompilation(HipaccKernel *K,
       break;
     case Language::OpenCLACC:
     case Language::OpenCLCPU:
-    case Language::OpenCLGPU:
+    case Language::OpenCLGPU: {
+      std::string build_options = "-I " + device.getCLIncludes() +
+                                  device.getCLBuildOptions();
       writeCLCompilation(K->getFileName(), K->getKernelName(),
-          device.getCLIncludes(), resultStr);
+          build_options, resultStr);
       if (K->getKernelClass()->getReduceFunction()) {
         resultStr += indent;
         writeCLCompilation(K->getFileName(), K->getReduceName(),
-            device.getCLIncludes(), resultStr, "2D");
+            build_options, resultStr, "2D");
         resultStr += indent;
         writeCLCompilation(K->getFileName(), K->getReduceName(),
-            device.getCLIncludes(), resultStr, "1D");
+            build_options, resultStr, "1D");
         if (K->getKernelClass()->getBinningFunction()) {
           writeCLCompilation(K->getFileName(), K->getBinningName(),
-              device.getCLIncludes(), resultStr, "2D");
+              build_options, resultStr, "2D");
           resultStr += indent;
           writeCLCompilation(K->getFileName(), K->getBinningName(),
-              device.getCLIncludes(), resultStr, "1D");
+              build_options, resultStr, "1D");
         }
       }
-      break;
+      break; }
   }
 }
 
@@ -421,7 +427,8 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   }
   infoStr = K->getInfoStr();
 
-  if (options.exploreConfig() || options.timeKernels()) {
+  // C99 kernels are called directly, explored kernels by the runtime tuner
+  if (!options.emitC99() && (options.exploreConfig() || options.timeKernels())) {
     inc_indent();
     resultStr += "{\n";
     switch (options.getTargetLang()) {
@@ -606,8 +613,14 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   #endif
 
 
+  // work per pixel for the metrics of C99 kernels
+  unsigned ops = 0, bytes = 0;
+  if (options.emitC99())
+    K->estimateWorkPerPixel(ops, bytes);
+
   // parameters
-  size_t cur_arg = 0;
+  size_t cur_arg = 0, cl_arg = 0;
+  std::map<std::string, size_t> cl_args;
   num_arg = 0;
   for (auto arg : K->getDeviceArgFields()) {
     size_t i = num_arg++;
@@ -635,7 +648,11 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
     std::string img_mem;
     if (Acc || Mask) img_mem = "->mem";
 
-    if (options.exploreConfig() || options.timeKernels()) {
+    // index of the OpenCL kernel argument
+    if (options.emitOpenCL())
+      cl_args[deviceArgNames[i]] = cl_arg++;
+
+    if (!options.emitC99() && (options.exploreConfig() || options.timeKernels())) {
       // add kernel argument
       switch (options.getTargetLang()) {
         case Language::C99: break;
@@ -672,12 +689,45 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
       switch (options.getTargetLang()) {
         case Language::C99:
           if (cur_arg++ == 0) {
-            resultStr += "hipaccStartTiming();\n";
+            if (options.exploreConfig()) {
+              resultStr += "hipaccLaunchKernelExplorationCPU(\"";
+              resultStr += kernel_name + "\", \"";
+              resultStr += K->getSourceHash() + "\", ";
+              resultStr += K->getIterationSpace()->getName() + ".width, ";
+              resultStr += K->getIterationSpace()->getName() + ".height, ";
+              resultStr += std::to_string(ops) + ", " + std::to_string(bytes);
+              resultStr += ", [&] (const hipacc_cpu_tile &_tile) {\n";
+              inc_indent();
+            } else {
+              resultStr += "hipaccStartTiming();\n";
+            }
             resultStr += indent;
-            resultStr += kernel_name + "(";
+            if (options.jitKernels()) {
+              resultStr += "hipaccLaunchKernelJIT(\"" + K->getFileName();
+              resultStr += ".cc\", \"" + kernel_name + "\", { ";
+            } else {
+              resultStr += kernel_name + "(";
+            }
           } else {
             resultStr += ", ";
           }
+          if (options.jitKernels()) {
+            // image memory and scalar kernel members are passed at launch,
+            // sizes, strides, offsets, bounds and masks are baked into the
+            // specialized kernel
+            if (Acc) {
+              resultStr += "hipaccJITPointer(" + hostArgNames[i] + img_mem + ")";
+            } else if (Mask) {
+              resultStr += "hipaccJITMask((const " + Mask->getTypeStr() + " *)";
+              resultStr += hostArgNames[i] + img_mem + ", ";
+              resultStr += std::to_string(Mask->getSizeX() * Mask->getSizeY()) + ")";
+            } else if (arg) {
+              resultStr += "hipaccJITValue(" + hostArgNames[i] + ")";
+            } else {
+              resultStr += "hipaccJITArg(" + hostArgNames[i] + ")";
+            }
+            break;
+          }
           if (Acc) {
             resultStr += "(" + Acc->getImage()->getTypeStr();
             resultStr += "(*)[" + Acc->getImage()->getSizeXStr() + "])";
@@ -721,15 +771,61 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   }
   if (options.getTargetLang()==Language::C99) {
     // close parenthesis for function call
+    if (options.jitKernels())
+      resultStr += " }";
     resultStr += ");\n";
-    resultStr += indent;
-    resultStr += "hipaccStopTiming();\n";
+    if (options.exploreConfig()) {
+      dec_indent();
+      resultStr += indent + "});\n";
+    } else {
+      resultStr += indent;
+      resultStr += "hipaccStopTiming(\"" + kernel_name + "\", ";
+      resultStr += K->getIterationSpace()->getName() + ".width, ";
+      resultStr += K->getIterationSpace()->getName() + ".height, ";
+      resultStr += std::to_string(ops) + ", " + std::to_string(bytes) + ");\n";
+    }
     resultStr += indent;
   }
   resultStr += "\n" + indent;
 
+  // OpenCL: image buffers of kernels whose rows can be split across devices;
+  // the runtime passes a sub-buffer and its first row per device
+  if (options.emitOpenCL() && options.multiDevice()) {
+    std::string bands;
+    bool split = true;
+    for (auto img : K->getKernelClass()->getImgFields()) {
+      HipaccAccessor *Acc = K->getImgFromMapping(img);
+      std::string name = img->getNameAsString();
+      if (!cl_args.count(name))
+        continue;
+
+      bool output = Acc == K->getIterationSpace();
+      int halo = K->getBandHalo(Acc);
+      std::string band_arg = "-1";
+      if (cl_args.count(name + "_band_y"))
+        band_arg = std::to_string(cl_args[name + "_band_y"]);
+      // image objects can't be split, inputs read entirely don't need to be
+      if ((output && halo < 0) || (band_arg == "-1" && halo >= 0)) {
+        split = false;
+        break;
+      }
+
+      if (!bands.empty())
+        bands += ", ";
+      bands += "hipaccBandArg(" + std::to_string(cl_args[name]) + ", ";
+      bands += band_arg + ", " + Acc->getName() + ", ";
+      bands += std::to_string(halo) + (output ? ", true)" : ", false)");
+    }
+
+    if (split && !bands.empty()) {
+      resultStr += "hipaccSetKernelBands(" + kernel_name + ", ";
+      resultStr += std::to_string(K->getPixelsPerThread()) + ", { ";
+      resultStr += bands + " });\n" + indent;
+    }
+  }
+
   // launch kernel
-  if (options.exploreConfig() || options.timeKernels()) {
+  if (!options.emitC99() && (options.exploreConfig() || options.timeKernels())) {
     switch (options.getTargetLang()) {
       case Language::C99: break;
       case Language::CUDA:
@@ -851,7 +947,9 @@ void CreateHostStrings::writeReduceCall(HipaccKernel *K, std::string &resultStr)
       }
       resultStr += ");\n";
       resultStr += indent;
-      resultStr += "hipaccStopTiming();\n";
+      resultStr += "hipaccStopTiming(\"" + K->getReduceName() + "\", ";
+      resultStr += K->getIterationSpace()->getName() + ".width, ";
+      resultStr += K->getIterationSpace()->getName() + ".height);\n";
       resultStr += indent;
       return;
     case Language::CUDA:
@@ -984,7 +1082,9 @@ void CreateHostStrings::writeBinningCall(HipaccKernel *K, std::string &resultStr
       }
       resultStr += ");\n";
       resultStr += indent;
-      resultStr += "hipaccStopTiming();\n";
+      resultStr += "hipaccStopTiming(\"" + K->getBinningName() + "\", ";
+      resultStr += K->getIterationSpace()->getName() + ".width, ";
+      resultStr += K->getIterationSpace()->getName() + ".height);\n";
       return;
     case Language::CUDA:
       // first get texture reference
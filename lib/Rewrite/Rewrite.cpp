@@ -38,7 +38,9 @@
 #endif
 #include "hipacc/AST/ASTNode.h"
 #include "hipacc/AST/ASTTranslate.h"
+#include "hipacc/Config/CompileReport.h"
 #include "hipacc/Config/CompilerOptions.h"
+#include "hipacc/Config/TimeReport.h"
 #include "hipacc/Device/TargetDescription.h"
 #include "hipacc/DSL/CompilerKnownClasses.h"
 #include "hipacc/Rewrite/CreateHostStrings.h"
@@ -46,17 +48,25 @@
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Rewrite/Core/Rewriter.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Path.h>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <algorithm>
+#include <mutex>
 
 #ifdef _WIN32
 # include <io.h>
+# include <sys/locking.h>
+# include <sys/stat.h>
 # define popen(x,y) _popen(x,y)
 # define pclose(x)  _pclose(x)
 # define fsync(x)
 #else
+# include <sys/file.h>
 # include <unistd.h>
 #endif
 
@@ -100,15 +110,26 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
     // store interpolation methods required for CUDA
     SmallVector<std::string, 16> InterpolationDefinitionsGlobal;
 
+    // content hashes of generated kernel files, keyed by file name, and the
+    // entries changed by this run (an empty hash removes the entry)
+    llvm::StringMap<std::string> KernelManifest;
+    llvm::StringMap<std::string> KernelManifestUpdates;
+
     // pointer to main function
     FunctionDecl *mainFD;
     FileID mainFileID;
     unsigned literalCount;
     bool skipTransfer;
+    bool visitedPCH;
+
+    // compile time measurements and kernel decisions, null if not requested
+    TimeReport *timeReport;
+    CompileReport *compileReport;
 
   public:
     Rewrite(CompilerInstance &CI, CompilerOptions &options,
-        std::unique_ptr<llvm::raw_pwrite_stream> Out) :
+        std::unique_ptr<llvm::raw_pwrite_stream> Out, TimeReport *report,
+        CompileReport *compile_report) :
       CI(CI),
       Context(CI.getASTContext()),
       Diags(CI.getASTContext().getDiagnostics()),
@@ -122,8 +143,13 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
       compilerClasses(CompilerKnownClasses()),
       mainFD(nullptr),
       literalCount(0),
-      skipTransfer(false)
-    {}
+      skipTransfer(false),
+      visitedPCH(false),
+      timeReport(report),
+      compileReport(compile_report)
+    {
+      readKernelManifest(KernelManifest);
+    }
 
     // RecursiveASTVisitor
     bool VisitCXXRecordDecl(CXXRecordDecl *D);
@@ -138,6 +164,9 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
     void HandleTranslationUnit(ASTContext &) override;
     bool HandleTopLevelDecl(DeclGroupRef D) override;
     void Initialize(ASTContext &Context) override {
+      // parsing is interleaved with the top-level declaration callbacks
+      if (timeReport)
+        timeReport->startPhase("Parsing");
       mainFileID = SM.getMainFileID();
       TextRewriter.setSourceMgr(SM, Context.getLangOpts());
       TextRewriteOptions.RemoveLineIfEmpty = true;
@@ -180,11 +209,17 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
       return LO;
     }
 
+    void readKernelManifest(llvm::StringMap<std::string> &Manifest);
+    void writeKernelManifest();
+    void writeKernelManifestLocked();
+    void writeKernelFile(std::string filename, std::string content,
+        bool cacheable);
+
     void setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K);
     void printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
-        llvm::raw_fd_ostream &OS);
+        llvm::raw_ostream &OS);
     void printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
-        llvm::raw_fd_ostream &OS);
+        llvm::raw_ostream &OS);
     void printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
         HipaccKernel *K, std::string file, bool emitHints);
 };
@@ -208,11 +243,17 @@ HipaccRewriteAction::CreateASTConsumer(CompilerInstance &CI,
     CI.createOutputFile(out, false, true, "", "", false);
   assert(OS && "Cannot create output stream.");
 
-  return llvm::make_unique<Rewrite>(CI, options, std::move(OS));
+  return llvm::make_unique<Rewrite>(CI, options, std::move(OS), report,
+      compile_report);
 }
 
 
 void Rewrite::HandleTranslationUnit(ASTContext &) {
+  if (timeReport) {
+    timeReport->stopPhase("Parsing");
+    timeReport->startPhase("Host code rewriting");
+  }
+
   assert(compilerClasses.Coordinate && "Coordinate class not found!");
   assert(compilerClasses.Image && "Image class not found!");
   assert(compilerClasses.BoundaryCondition && "BoundaryCondition class not found!");
@@ -418,10 +459,29 @@ void Rewrite::HandleTranslationUnit(ASTContext &) {
   } else {
     llvm::errs() << "No changes to input file, something went wrong!\n";
   }
+
+  if (timeReport)
+    timeReport->stopPhase("Host code rewriting");
+
+  TimeReport::Region Time(timeReport, "Kernel file output");
+  writeKernelManifest();
 }
 
 
 bool Rewrite::HandleTopLevelDecl(DeclGroupRef DGR) {
+  if (timeReport)
+    timeReport->stopPhase("Parsing");
+
+  // DSL headers loaded from a precompiled header are not passed to the
+  // consumer; visit them once, in their original order, before the first
+  // declaration of the input file
+  if (!visitedPCH && Context.getExternalSource()) {
+    visitedPCH = true;
+    for (auto decl : Context.getTranslationUnitDecl()->decls())
+      if (decl->isFromASTFile())
+        TraverseDecl(decl);
+  }
+
   for (auto decl : DGR) {
     if (compilerClasses.HipaccEoP) {
       // skip late template class instantiations when templated class instances
@@ -433,6 +493,9 @@ bool Rewrite::HandleTopLevelDecl(DeclGroupRef DGR) {
     TraverseDecl(decl);
   }
 
+  if (timeReport)
+    timeReport->startPhase("Parsing");
+
   return true;
 }
 
@@ -612,6 +675,7 @@ bool Rewrite::VisitCXXRecordDecl(CXXRecordDecl *D) {
     for (auto method : D->methods()) {
       // kernel function
       if (method->getNameAsString() == "kernel") {
+        TimeReport::Region Time(timeReport, "Kernel statistics");
         KC->setKernelFunction(method, compilerClasses);
         continue;
       }
@@ -1290,27 +1354,41 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
             }
           }
 
+          // specialize the kernel for constant scalar arguments; instances
+          // with runtime arguments keep them as kernel parameters
+          K->setConstArgs(llvm::makeArrayRef(CCE->getArgs(),
+                CCE->getNumArgs()));
+
+          TimeReport::Region KernelTime(timeReport, K->getKernelName(), true);
+
           // set kernel configuration
-          setKernelConfiguration(KC, K);
+          {
+            TimeReport::Region Time(timeReport, "Resource estimation");
+            setKernelConfiguration(KC, K);
+          }
 
           // kernel declaration
           FunctionDecl *kernelDecl = createFunctionDecl(Context,
               Context.getTranslationUnitDecl(), K->getKernelName(),
               Context.VoidTy, K->getArgTypes(), K->getDeviceArgNames());
 
-          // translate kernel function, replaces member variables
-          ASTTranslate *Hipacc = new ASTTranslate(Context, kernelDecl, K, KC,
-              builtins, compilerOptions);
-          Stmt *kernelStmts =
-            Hipacc->Hipacc(KC->getKernelFunction()->getBody());
-          kernelDecl->setBody(kernelStmts);
-          K->printStats();
-
-          // translate binning function if we have one
-          if (KC->getBinningFunction()) {
-            Stmt *binningStmts = Hipacc->translateBinning(
-                KC->getBinningFunction()->getBody());
-            KC->getBinningFunction()->setBody(binningStmts);
+          {
+            TimeReport::Region Time(timeReport, "Kernel translation");
+
+            // translate kernel function, replaces member variables
+            ASTTranslate *Hipacc = new ASTTranslate(Context, kernelDecl, K, KC,
+                builtins, compilerOptions);
+            Stmt *kernelStmts =
+              Hipacc->Hipacc(KC->getKernelFunction()->getBody());
+            kernelDecl->setBody(kernelStmts);
+            K->printStats();
+
+            // translate binning function if we have one
+            if (KC->getBinningFunction()) {
+              Stmt *binningStmts = Hipacc->translateBinning(
+                  KC->getBinningFunction()->getBody());
+              KC->getBinningFunction()->setBody(binningStmts);
+            }
           }
 
           #ifdef USE_POLLY
@@ -1325,7 +1403,13 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
           #endif
 
           // write kernel to file
-          printKernelFunction(kernelDecl, KC, K, K->getFileName(), true);
+          {
+            TimeReport::Region Time(timeReport, "Kernel emission");
+            printKernelFunction(kernelDecl, KC, K, K->getFileName(), true);
+          }
+
+          if (compileReport)
+            compileReport->addKernel(K->getReport());
 
           break;
         }
@@ -1876,7 +1960,7 @@ void Rewrite::setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K) {
 
 
 void Rewrite::printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
-    llvm::raw_fd_ostream &OS) {
+    llvm::raw_ostream &OS) {
   FunctionDecl *bin_fun = KC->getBinningFunction();
   QualType pixelType = KC->getPixelType();
   QualType binType = KC->getBinType();
@@ -2034,7 +2118,7 @@ void Rewrite::printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
 
 
 void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
-    llvm::raw_fd_ostream &OS) {
+    llvm::raw_ostream &OS) {
   FunctionDecl *fun = KC->getReduceFunction();
 
   // preprocessor defines
@@ -2198,9 +2282,146 @@ void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
 }
 
 
+#define KERNEL_MANIFEST "hipacc_kernels.manifest"
+
+// The manifest maps each generated kernel file to the MD5 of its content.
+// Kernel files whose content did not change are not touched, so that build
+// systems only recompile kernels that were actually affected by an edit. The
+// manifest only selects the candidates: a kernel is skipped if the file on
+// disk still has the new content, since a run may have stopped after writing
+// kernels but before updating the manifest.
+void Rewrite::readKernelManifest(llvm::StringMap<std::string> &Manifest) {
+  auto Buffer = llvm::MemoryBuffer::getFile(KERNEL_MANIFEST);
+  if (!Buffer)
+    return;
+
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', -1, false);
+  for (auto Line : Lines) {
+    auto Entry = Line.trim().split(' ');
+    if (Entry.first.size() == 32 && !Entry.second.empty())
+      Manifest[Entry.second] = Entry.first;
+  }
+}
+
+
+void Rewrite::writeKernelManifest() {
+  if (KernelManifestUpdates.empty())
+    return;
+
+  // several inputs may be compiled concurrently in batch mode or by other
+  // processes: merge the changes of this run into the current manifest while
+  // holding an advisory lock
+  static std::mutex manifest_mutex;
+  std::lock_guard<std::mutex> lock(manifest_mutex);
+#ifdef _WIN32
+  int lock_fd = _open(KERNEL_MANIFEST ".lock", _O_CREAT | _O_RDWR,
+                      _S_IREAD | _S_IWRITE);
+  if (lock_fd >= 0 && _locking(lock_fd, _LK_LOCK, 1) != 0) {
+    _close(lock_fd);
+    lock_fd = -1;
+  }
+#else
+  int lock_fd = open(KERNEL_MANIFEST ".lock", O_CREAT | O_RDWR, 0644);
+  if (lock_fd >= 0 && flock(lock_fd, LOCK_EX) != 0) {
+    close(lock_fd);
+    lock_fd = -1;
+  }
+#endif
+  if (lock_fd < 0)
+    llvm::errs() << "Warning: could not lock kernel manifest '"
+                 << KERNEL_MANIFEST << "'\n";
+
+  writeKernelManifestLocked();
+
+  if (lock_fd >= 0) {
+#ifdef _WIN32
+    _lseek(lock_fd, 0, SEEK_SET);
+    _locking(lock_fd, _LK_UNLCK, 1);
+    _close(lock_fd);
+#else
+    close(lock_fd);
+#endif
+  }
+}
+
+
+void Rewrite::writeKernelManifestLocked() {
+  llvm::StringMap<std::string> Manifest;
+  readKernelManifest(Manifest);
+  for (auto &Update : KernelManifestUpdates) {
+    if (Update.second.empty())
+      Manifest.erase(Update.getKey());
+    else
+      Manifest[Update.getKey()] = Update.second;
+  }
+
+  int fd;
+  SmallString<128> tmp_file;
+  std::error_code EC = llvm::sys::fs::createUniqueFile(
+      KERNEL_MANIFEST "-%%%%%%.tmp", fd, tmp_file);
+  if (EC) {
+    llvm::errs() << "Warning: could not write kernel manifest '"
+                 << KERNEL_MANIFEST << "': " << EC.message() << "\n";
+    return;
+  }
+  {
+    llvm::raw_fd_ostream OS(fd, true);
+    // sort entries for a stable manifest
+    std::vector<StringRef> Files;
+    for (auto &Entry : Manifest)
+      Files.push_back(Entry.getKey());
+    std::sort(Files.begin(), Files.end());
+    for (auto File : Files)
+      OS << Manifest[File] << " " << File << "\n";
+  }
+  if ((EC = llvm::sys::fs::rename(tmp_file, KERNEL_MANIFEST)))
+    llvm::errs() << "Warning: could not write kernel manifest '"
+                 << KERNEL_MANIFEST << "': " << EC.message() << "\n";
+}
+
+
+void Rewrite::writeKernelFile(std::string filename, std::string content,
+    bool cacheable) {
+  llvm::MD5 Hash;
+  Hash.update(content);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  std::string hash = Result.digest().str();
+
+  // skip unchanged kernels
+  auto Entry = KernelManifest.find(filename);
+  if (cacheable && Entry != KernelManifest.end() && Entry->second == hash) {
+    auto Buffer = llvm::MemoryBuffer::getFile(filename);
+    if (Buffer && (*Buffer)->getBuffer() == content)
+      return;
+  }
+
+  // open file stream using own file descriptor. We need to call fsync() to
+  // compile the generated code using nvcc afterwards.
+  int fd;
+  while ((fd = open(filename.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0664)) < 0) {
+    if (errno != EINTR) {
+      std::string errorInfo("Error opening output file '" + filename + "'");
+      perror(errorInfo.c_str());
+    }
+  }
+  llvm::raw_fd_ostream OS(fd, false);
+  OS << content;
+  OS.flush();
+  fsync(fd);
+  close(fd);
+
+  // intermediate versions (resource estimation) invalidate the entry
+  if (!cacheable)
+    hash.clear();
+  KernelManifest[filename] = hash;
+  KernelManifestUpdates[filename] = hash;
+}
+
+
 void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     HipaccKernel *K, std::string file, bool emitHints) {
-  int fd;
   std::string filename(file);
   std::string ifdef("_" + file + "_");
   switch (compilerOptions.getTargetLang()) {
@@ -2213,15 +2434,9 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     case Language::Filterscript: filename += ".fs"; ifdef += "FS_"; break;
   }
 
-  // open file stream using own file descriptor. We need to call fsync() to
-  // compile the generated code using nvcc afterwards.
-  while ((fd = open(filename.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0664)) < 0) {
-    if (errno != EINTR) {
-      std::string errorInfo("Error opening output file '" + filename + "'");
-      perror(errorInfo.c_str());
-    }
-  }
-  llvm::raw_fd_ostream OS(fd, false);
+  // generate kernel in memory, the file is only written if it changed
+  std::string content;
+  llvm::raw_string_ostream OS(content);
 
   // write ifndef, ifdef
   std::transform(ifdef.begin(), ifdef.end(), ifdef.begin(), ::toupper);
@@ -2634,6 +2849,19 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
     OS << "}\n";
   OS << "\n";
 
+  // tuned configurations of explored C99 kernels are stored per kernel source
+  if (compilerOptions.emitC99() && compilerOptions.exploreConfig() && emitHints) {
+    std::string body;
+    llvm::raw_string_ostream BS(body);
+    D->getBody()->printPretty(BS, 0, Policy, 0);
+    llvm::MD5 Hash;
+    Hash.update(K->getKernelName());
+    Hash.update(BS.str());
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    K->setSourceHash(Result.digest().str());
+  }
+
   if (KC->getReduceFunction())
     printReductionFunction(KC, K, OS);
 
@@ -2643,9 +2871,7 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
 
   OS << "#endif //" + ifdef + "\n";
   OS << "\n";
-  OS.flush();
-  fsync(fd);
-  close(fd);
+  writeKernelFile(filename, OS.str(), emitHints);
 }
 
 // vim: set ts=2 sw=2 sts=2 et ai:
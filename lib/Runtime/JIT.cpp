@@ -0,0 +1,2 @@
+// Hipacc JIT runtime definitions for C/C++ kernels
+#include <hipacc_cpu_jit_standalone.hpp>
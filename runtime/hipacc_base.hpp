@@ -36,9 +36,18 @@
 #include <vector>
 
 #include "hipacc_math_functions.hpp"
+#include "hipacc_metrics.hpp"
+#include "hipacc_trace.hpp"
+#include "hipacc_tuning.hpp"
 
 #define HIPACC_NUM_ITERATIONS 10
 
+// pyramid levels with fewer pixels than this are considered coarse: kernels
+// operating on them are executed without spawning a parallel region
+#ifndef HIPACC_PYRAMID_COARSE_PIXELS
+# define HIPACC_PYRAMID_COARSE_PIXELS 16384
+#endif
+
 #ifdef _WIN32
 # define setenv(a,b,c) _putenv_s(a,b)
 #endif
@@ -109,6 +118,9 @@ typedef struct hipacc_launch_info {
     int bh_start_left, bh_start_right;
     int bh_start_top, bh_start_bottom;
     int bh_fall_back;
+    // first row of the image buffers, changed by the runtime for each device
+    // when the rows are split across devices
+    int band_y;
 } hipacc_launch_info;
 
 
@@ -134,6 +146,7 @@ class HipaccPyramid {
     int level() const;
     bool is_top_level() const;
     bool is_bottom_level() const;
+    bool is_coarse_level() const;
     void swap(HipaccPyramid &other);
     bool bind();
     void unbind();
@@ -154,6 +167,8 @@ void hipaccTraverse(std::vector<HipaccPyramid*> pyrs,
                     const std::function<void()> func);
 void hipaccTraverse(unsigned int loop=1,
                     const std::function<void()> func=[]{});
+bool hipaccTraverseCoarseLevel();
+int hipaccTraverseLevel();
 
 
 // templates
@@ -161,9 +176,15 @@ template<typename data_t>
 HipaccPyramid hipaccCreatePyramid(const HipaccImage &img, size_t depth);
 
 
+template<typename data_t>
+std::vector<HipaccImage> hipaccAllocPyramidLevels(const HipaccImage &img, size_t depth);
+
+
 // forward declarations
 template<typename T>
 HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height);
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth);
 
 
 #include "hipacc_base.tpp"
@@ -32,15 +32,26 @@ HipaccPyramid hipaccCreatePyramid(const HipaccImage &img, size_t depth) {
     HipaccPyramid p(depth);
     p.add(img);
 
+    for (auto &level : hipaccCreatePyramidImages<data_t>(img, depth))
+        p.add(level);
+    return p;
+}
+
+
+// Allocate each pyramid level below the base image separately
+template<typename data_t>
+std::vector<HipaccImage> hipaccAllocPyramidLevels(const HipaccImage &img, size_t depth) {
+    std::vector<HipaccImage> levels;
+
     size_t width  = img->width  / 2;
     size_t height = img->height / 2;
     for (size_t i=1; i<depth; ++i) {
         assert(width * height > 0 && "Pyramid stages too deep for image size");
-        p.add(hipaccCreatePyramidImage<data_t>(img, width, height));
+        levels.push_back(hipaccCreatePyramidImage<data_t>(img, width, height));
         width  /= 2;
         height /= 2;
     }
-    return p;
+    return levels;
 }
 
 
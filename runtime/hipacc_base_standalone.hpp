@@ -34,6 +34,11 @@
 #define __HIPACC_BASE_STANDALONE_HPP__
 
 
+#include "hipacc_metrics_standalone.hpp"
+#include "hipacc_trace_standalone.hpp"
+#include "hipacc_tuning_standalone.hpp"
+
+
 float hipacc_last_timing = 0.0f;
 float hipacc_last_kernel_timing() {
     return hipacc_last_timing;
@@ -76,14 +81,14 @@ hipacc_launch_info::hipacc_launch_info(int size_x, int size_y, int is_width, int
     size_x(size_x), size_y(size_y), is_width(is_width),
     is_height(is_height), offset_x(offset_x), offset_y(offset_y), pixels_per_thread(pixels_per_thread), simd_width(simd_width),
     bh_start_left(0), bh_start_right(0), bh_start_top(0),
-    bh_start_bottom(0), bh_fall_back(0) {}
+    bh_start_bottom(0), bh_fall_back(0), band_y(0) {}
 
 hipacc_launch_info::hipacc_launch_info(int size_x, int size_y, HipaccAccessor &Acc, int pixels_per_thread, int simd_width) :
     size_x(size_x), size_y(size_y), is_width(Acc.width),
     is_height(Acc.height), offset_x(Acc.offset_x), offset_y(Acc.offset_y),
     pixels_per_thread(pixels_per_thread), simd_width(simd_width),
     bh_start_left(0), bh_start_right(0), bh_start_top(0),
-    bh_start_bottom(0), bh_fall_back(0) {}
+    bh_start_bottom(0), bh_fall_back(0), band_y(0) {}
 
 
 hipacc_smem_info::hipacc_smem_info(int size_x, int size_y, int pixel_size) :
@@ -120,10 +125,13 @@ bool HipaccPyramid::is_bottom_level() const {
     return level_ == depth_-1;
 }
 
+bool HipaccPyramid::is_coarse_level() const {
+    const HipaccImage &img = imgs_.at(level_);
+    return img->width * img->height < HIPACC_PYRAMID_COARSE_PIXELS;
+}
+
 void HipaccPyramid::swap(HipaccPyramid &other) {
-    std::vector<HipaccImage> tmp = other.imgs_;
-    other.imgs_ = this->imgs_;
-    this->imgs_ = tmp;
+    imgs_.swap(other.imgs_);
 }
 
 bool HipaccPyramid::bind() {
@@ -143,6 +151,40 @@ void HipaccPyramid::unbind() {
 
 std::vector<const std::function<void()>*> hipaccTraverseFunc;
 std::vector<std::vector<HipaccPyramid*>>  hipaccPyramids;
+bool hipaccCoarseLevel = false;
+
+
+// Update the coarse level flag for the innermost traversal: the level is coarse
+// only if it is coarse for all pyramids traversed together.
+void hipaccUpdateCoarseLevel() {
+    hipaccCoarseLevel = false;
+    if (hipaccPyramids.empty())
+        return;
+
+    hipaccCoarseLevel = true;
+    for (auto pyr : hipaccPyramids.back())
+        hipaccCoarseLevel &= pyr->is_coarse_level();
+}
+
+bool hipaccTraverseCoarseLevel() {
+    return hipaccCoarseLevel;
+}
+
+// Current level of the innermost traversal, -1 outside of any traversal
+int hipaccTraverseLevel() {
+    if (hipaccPyramids.empty())
+        return -1;
+    return hipaccPyramids.back().at(0)->level();
+}
+
+
+// Execute the traversal function for the current level
+void hipaccTraverseStep(const std::function<void()> &func) {
+    HipaccImage &img = (*hipaccPyramids.back().at(0))(0);
+    HipaccTraceScope trace("traverse", "traverse", img->width, img->height,
+                           hipaccTraverseLevel());
+    func();
+}
 
 
 void hipaccTraverse(HipaccPyramid &p0, const std::function<void()> func) {
@@ -153,11 +195,13 @@ void hipaccTraverse(HipaccPyramid &p0, const std::function<void()> func) {
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     p0.unbind();
 }
@@ -177,11 +221,13 @@ void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1,
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     p0.unbind();
     p1.unbind();
@@ -205,11 +251,13 @@ void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     p0.unbind();
     p1.unbind();
@@ -237,11 +285,13 @@ void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     p0.unbind();
     p1.unbind();
@@ -274,11 +324,13 @@ void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     p0.unbind();
     p1.unbind();
@@ -299,11 +351,13 @@ void hipaccTraverse(std::vector<HipaccPyramid*> pyrs,
 
     hipaccPyramids.push_back(pyrs);
     hipaccTraverseFunc.push_back(&func);
+    hipaccUpdateCoarseLevel();
 
-    (*hipaccTraverseFunc.back())();
+    hipaccTraverseStep(*hipaccTraverseFunc.back());
 
     hipaccTraverseFunc.pop_back();
     hipaccPyramids.pop_back();
+    hipaccUpdateCoarseLevel();
 
     for (auto pyr : pyrs)
         pyr->unbind();
@@ -319,9 +373,10 @@ void hipaccTraverse(unsigned int loop,
     if (!pyrs.at(0)->is_bottom_level()) {
         for (auto pyr : pyrs)
             ++pyr->level_;
+        hipaccUpdateCoarseLevel();
 
         for (size_t i=0; i<loop; i++) {
-            (*hipaccTraverseFunc.back())();
+            hipaccTraverseStep(*hipaccTraverseFunc.back());
             if (i < loop-1) {
                 func();
             }
@@ -329,6 +384,7 @@ void hipaccTraverse(unsigned int loop,
 
         for (auto pyr : pyrs)
             --pyr->level_;
+        hipaccUpdateCoarseLevel();
     }
 }
 
@@ -43,13 +43,19 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "hipacc_base.hpp"
 
+// version of the OpenCL runtime and the kernel interface it expects, part of
+// the key of cached program binaries
+#define HIPACC_CL_RUNTIME_VERSION "0.8.3"
+
 #define EVENT_TIMING
 
 enum cl_platform_name {
@@ -69,6 +75,31 @@ std::string getOpenCLErrorCodeStr(int error);
 inline void __checkOpenCLErrors(cl_int err, std::string name, std::string file, const int line);
 
 
+// image buffer of a kernel whose rows can be split across devices
+typedef struct hipacc_band_arg {
+    // kernel arguments of the buffer and its first row (-1 if not used)
+    int mem_arg, band_arg;
+    cl_mem mem;
+    // bytes per row and rows of the buffer
+    size_t pitch, height;
+    // rows accessed for the iteration space rows 0 ... rows-1
+    int offset_y, rows;
+    // rows read above and below the current row, -1 if any row is read
+    int halo;
+    bool output;
+} hipacc_band_arg;
+
+typedef struct hipacc_kernel_bands {
+    int pixels_per_thread;
+    std::vector<hipacc_band_arg> args;
+} hipacc_kernel_bands;
+
+typedef struct hipacc_tuned_kernel {
+    cl_kernel kernel;
+    int tile_size_x, tile_size_y;
+} hipacc_tuned_kernel;
+
+
 class HipaccContext : public HipaccContextBase {
     private:
         std::vector<cl_platform_id> platforms;
@@ -76,6 +107,24 @@ class HipaccContext : public HipaccContextBase {
         std::vector<cl_device_id> devices, devices_all;
         std::vector<cl_context> contexts;
         std::vector<cl_command_queue> queues;
+        // asynchronous mode: last event enqueued to each command queue and
+        // pending writes from the host copy of a memory object
+        bool async = false;
+        std::vector<cl_event> events;
+        std::map<cl_mem, cl_event> host_writes;
+        // multi-device mode: alignment of sub-buffer origins, compute units
+        // and block rows processed per ms on each device per kernel, and
+        // image buffers of the kernels that can be split; only kernels
+        // translated with -multi-device register their buffers, all others
+        // and global reductions run on the first device
+        bool multi_device = false;
+        size_t sub_buffer_align = 1;
+        std::vector<double> device_units;
+        std::map<cl_kernel, std::vector<double>> device_rates;
+        std::map<cl_kernel, hipacc_kernel_bands> kernel_bands;
+        // explored kernels built with their tuned configuration, per kernel
+        // file, kernel and iteration space
+        std::map<std::string, hipacc_tuned_kernel> tuned_kernels;
 
     public:
         static HipaccContext &getInstance();
@@ -90,6 +139,24 @@ class HipaccContext : public HipaccContextBase {
         std::vector<cl_device_id> get_devices_all();
         std::vector<cl_context> get_contexts();
         std::vector<cl_command_queue> get_command_queues();
+        void set_async(bool enable);
+        bool is_async();
+        std::vector<cl_event> get_wait_list(int num_queue);
+        void add_event(int num_queue, cl_event event);
+        void add_host_write(cl_mem mem, cl_event event);
+        void wait_host_write(cl_mem mem);
+        void synchronize();
+        void set_multi_device(bool enable);
+        bool is_multi_device();
+        void set_sub_devices(std::vector<cl_device_id> ids);
+        size_t get_sub_buffer_align();
+        std::vector<double> get_device_units();
+        std::vector<double> &get_device_rates(cl_kernel kernel);
+        void set_kernel_bands(cl_kernel kernel, const hipacc_kernel_bands &bands);
+        void remove_kernel_bands(cl_kernel kernel);
+        hipacc_kernel_bands *get_kernel_bands(cl_kernel kernel);
+        void add_tuned_kernel(const std::string &key, const hipacc_tuned_kernel &kernel);
+        hipacc_tuned_kernel *get_tuned_kernel(const std::string &key);
 };
 
 class HipaccImageOpenCL : public HipaccImageBase {
@@ -104,19 +171,36 @@ class HipaccImageOpenCL : public HipaccImageBase {
 };
 
 
+inline const cl_event *hipaccEventList(const std::vector<cl_event> &events) {
+    return events.empty() ? NULL : events.data();
+}
+
+
 void hipaccPrepareKernelLaunch(hipacc_launch_info &info, size_t *block);
 void hipaccCalcGridFromBlock(hipacc_launch_info &info, size_t *block, size_t *grid);
 void hipaccInitPlatformsAndDevices(cl_device_type dev_type, cl_platform_name platform_name=ALL);
 std::vector<cl_device_id> hipaccGetAllDevices();
 void hipaccCreateContextsAndCommandQueues(bool all_devies=false);
+void hipaccSetAsync(bool enable);
+void hipaccSynchronize();
 void hipaccDumpBinary(cl_program program, cl_device_id device);
+std::string hipaccBinaryCacheDir();
+std::string hipaccBinaryCacheFile(std::string file_name, const std::string &source, const std::string &build_options, std::vector<cl_device_id> &devices);
+std::vector<cl_device_id> hipaccGetContextDevices();
+cl_program hipaccLoadProgramBinary(const std::string &cache_file, std::vector<cl_device_id> &devices, const std::string &build_options);
+void hipaccStoreProgramBinary(const std::string &cache_file, cl_program program, std::vector<cl_device_id> &devices);
 cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_name, bool print_progress=true, bool dump_binary=false, bool print_log=false, std::string build_options=std::string(), std::string build_includes=std::string());
 cl_sampler hipaccCreateSampler(cl_bool normalized_coords, cl_addressing_mode addressing_mode, cl_filter_mode filter_mode);
 void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst, int num_device=0);
 void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst, int num_device=0);
 double hipaccCopyBufferBenchmark(const HipaccImage &src, HipaccImage &dst, int num_device=0, bool print_timing=false);
+hipacc_band_arg hipaccBandArg(int mem_arg, int band_arg, const HipaccAccessor &acc, int halo, bool output);
+void hipaccSetKernelBands(cl_kernel kernel, int pixels_per_thread, std::vector<hipacc_band_arg> args);
+void hipaccLaunchKernelMultiDevice(cl_kernel kernel, const hipacc_kernel_bands &bands, size_t *global_work_size, size_t *local_work_size, bool print_timing=true);
+void hipaccReadBufferSync(cl_mem mem, size_t size, void *host_mem, int num_device=0);
 void hipaccLaunchKernel(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, bool print_timing=true);
 void hipaccLaunchKernelBenchmark(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, std::vector<std::pair<size_t, void *> > args, bool print_timing=true);
+void hipaccTuningKey(std::string filename, std::string kernel, hipacc_launch_info &info, std::string &scope, std::string &version);
 void hipaccLaunchKernelExploration(std::string filename, std::string kernel,
         std::vector<std::pair<size_t, void *> > args,
         std::vector<hipacc_smem_info> smems, hipacc_launch_info &info, int
@@ -163,6 +247,8 @@ template<typename T, typename T2>
 T *hipaccApplyBinningSegmented(cl_kernel kernel2D, cl_kernel kernel1D, const HipaccAccessor &acc, unsigned int num_hists, unsigned int num_warps, unsigned int num_bins);
 template<typename T>
 HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height);
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth);
 
 
 #include "hipacc_cl.tpp"
@@ -115,10 +115,17 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem, int num_device) {
     size_t height = img->height;
     size_t stride = img->stride;
 
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    // the host copy may still be read by a previous asynchronous write
+    Ctx.wait_host_write((cl_mem)img->mem);
+
     if ((char *)host_mem != img->host)
         std::copy(host_mem, host_mem + width*height, (T*)img->host);
+    // write from the host copy, the caller may reuse host_mem immediately
+    host_mem = (T*)img->host;
 
-    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(num_device);
+    cl_event event;
     cl_int err = CL_SUCCESS;
     if (img->mem_type >= Array2D) {
         const size_t origin[] = { 0, 0, 0 };
@@ -127,20 +134,25 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem, int num_device) {
         const size_t input_row_pitch = width*sizeof(T);
         const size_t input_slice_pitch = 0;
 
-        err = clEnqueueWriteImage(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, origin, region, input_row_pitch, input_slice_pitch, host_mem, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueWriteImage(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, origin, region, input_row_pitch, input_slice_pitch, host_mem, wait_list.size(), hipaccEventList(wait_list), &event);
         checkErr(err, "clEnqueueWriteImage()");
     } else {
         if (stride > width) {
             for (size_t i=0; i<height; ++i) {
-                err |= clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &host_mem[i*width], 0, NULL, NULL);
+                err |= clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &host_mem[i*width], wait_list.size(), hipaccEventList(wait_list), i==height-1 ? &event : NULL);
             }
         } else {
-            err = clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, 0, sizeof(T)*width*height, host_mem, 0, NULL, NULL);
+            err = clEnqueueWriteBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, 0, sizeof(T)*width*height, host_mem, wait_list.size(), hipaccEventList(wait_list), &event);
         }
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueWriteBuffer()");
     }
+
+    Ctx.add_host_write((cl_mem)img->mem, event);
+    Ctx.add_event(num_device, event);
+    if (!Ctx.is_async()) {
+        err = clFinish(Ctx.get_command_queues()[num_device]);
+        checkErr(err, "clFinish()");
+    }
 }
 
 
@@ -149,6 +161,9 @@ template<typename T>
 T *hipaccReadMemory(const HipaccImage &img, int num_device) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    // host reads are the only synchronization points in asynchronous mode
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(num_device);
+    cl_event event;
 
     if (img->mem_type >= Array2D) {
         const size_t origin[] = { 0, 0, 0 };
@@ -157,8 +172,9 @@ T *hipaccReadMemory(const HipaccImage &img, int num_device) {
         const size_t row_pitch = img->width*sizeof(T);
         const size_t slice_pitch = 0;
 
-        err = clEnqueueReadImage(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, origin, region, row_pitch, slice_pitch, (T*)img->host, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueReadImage(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, origin, region, row_pitch, slice_pitch, (T*)img->host, wait_list.size(), hipaccEventList(wait_list), &event);
+        err |= clWaitForEvents(1, &event);
+        err |= clReleaseEvent(event);
         checkErr(err, "clEnqueueReadImage()");
     } else {
         size_t width = img->width;
@@ -167,12 +183,13 @@ T *hipaccReadMemory(const HipaccImage &img, int num_device) {
 
         if (stride > width) {
             for (size_t i=0; i<height; ++i) {
-                err |= clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &((T*)img->host)[i*width], 0, NULL, NULL);
+                err |= clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, i*sizeof(T)*stride, sizeof(T)*width, &((T*)img->host)[i*width], wait_list.size(), hipaccEventList(wait_list), i==height-1 ? &event : NULL);
             }
         } else {
-            err = clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, 0, sizeof(T)*width*height, (T*)img->host, 0, NULL, NULL);
+            err = clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], (cl_mem)img->mem, CL_FALSE, 0, sizeof(T)*width*height, (T*)img->host, wait_list.size(), hipaccEventList(wait_list), &event);
         }
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err |= clWaitForEvents(1, &event);
+        err |= clReleaseEvent(event);
         checkErr(err, "clEnqueueReadBuffer()");
     }
 
@@ -205,6 +222,8 @@ void hipaccSetKernelArg(cl_kernel kernel, unsigned int num, size_t size, T* para
 
 
 // Perform global reduction and return result
+// The reduction kernels have no bands and always run on the first device,
+// partial results are not merged across devices in multi-device mode.
 template<typename T>
 T hipaccApplyReduction(cl_kernel kernel2D, cl_kernel kernel1D, const HipaccAccessor &acc, unsigned int max_threads, unsigned int pixels_per_thread) {
     HipaccContext &Ctx = HipaccContext::getInstance();
@@ -273,9 +292,7 @@ T hipaccApplyReduction(cl_kernel kernel2D, cl_kernel kernel1D, const HipaccAcces
     hipaccLaunchKernel(kernel1D, global_work_size, local_work_size);
 
     // get reduced value
-    err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(T), &result, 0, NULL, NULL);
-    err |= clFinish(Ctx.get_command_queues()[0]);
-    checkErr(err, "clEnqueueReadBuffer()");
+    hipaccReadBufferSync(output, sizeof(T), &result);
 
     err = clReleaseMemObject(output);
     checkErr(err, "clReleaseMemObject()");
@@ -305,6 +322,10 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D, st
 
     std::cerr << "<HIPACC:> Exploring pixels per thread for '" << kernel2D << ", " << kernel1D << "'" << std::endl;
 
+    // timing requires synchronous launches
+    bool async = Ctx.is_async();
+    Ctx.set_async(false);
+
     float opt_time = FLT_MAX;
     int opt_ppt = 1;
     for (size_t ppt=1; ppt<=acc.height; ++ppt) {
@@ -398,15 +419,14 @@ T hipaccApplyReductionExploration(std::string filename, std::string kernel2D, st
         err = clReleaseKernel(exploreReduction1D);
         checkErr(err, "clReleaseKernel()");
     }
+    Ctx.set_async(async);
     hipacc_last_timing = opt_time;
     std::cerr << "<HIPACC:> Best unroll factor for reduction kernel '"
               << kernel2D << "/" << kernel1D << "': "
               << opt_ppt << ": " << opt_time << " ms" << std::endl;
 
     // get reduced value
-    err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(T), &result, 0, NULL, NULL);
-    err |= clFinish(Ctx.get_command_queues()[0]);
-    checkErr(err, "clEnqueueReadBuffer()");
+    hipaccReadBufferSync(output, sizeof(T), &result);
 
     err = clReleaseMemObject(output);
     checkErr(err, "clReleaseMemObject()");
@@ -477,9 +497,7 @@ T *hipaccApplyBinningSegmented(cl_kernel kernel2D, cl_kernel kernel1D, const Hip
 
     hipaccLaunchKernel(kernel1D, global_work_size, local_work_size);
 
-    err = clEnqueueReadBuffer(Ctx.get_command_queues()[0], output, CL_FALSE, 0, sizeof(T)*num_bins, result, 0, NULL, NULL);
-    err |= clFinish(Ctx.get_command_queues()[0]);
-    checkErr(err, "clEnqueueReadBuffer()");
+    hipaccReadBufferSync(output, sizeof(T)*num_bins, result);
 
     err = clReleaseMemObject(output);
     checkErr(err, "clReleaseMemObject()");
@@ -508,5 +526,11 @@ HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size
 }
 
 
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth) {
+  return hipaccAllocPyramidLevels<T>(base, depth);
+}
+
+
 #endif  // __HIPACC_CL_TPP__
 
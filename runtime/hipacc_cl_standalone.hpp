@@ -37,6 +37,18 @@
 
 #include "hipacc_base_standalone.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 
 std::string getOpenCLErrorCodeStr(int error) {
     #define CL_ERROR_CODE(CODE) case CODE: return #CODE;
@@ -153,6 +165,7 @@ void HipaccContext::add_context(cl_context id) {
 
 void HipaccContext::add_command_queue(cl_command_queue id) {
     queues.push_back(id);
+    events.push_back(NULL);
 }
 
 std::vector<cl_platform_id> HipaccContext::get_platforms() {
@@ -179,6 +192,133 @@ std::vector<cl_command_queue> HipaccContext::get_command_queues() {
     return queues;
 }
 
+void HipaccContext::set_async(bool enable) {
+    if (async && !enable) synchronize();
+    async = enable;
+}
+
+bool HipaccContext::is_async() {
+    return async;
+}
+
+// Commands are only ordered within an in-order queue, hence a command has to
+// wait for the commands enqueued to all other queues
+std::vector<cl_event> HipaccContext::get_wait_list(int num_queue) {
+    std::vector<cl_event> wait_list;
+    for (size_t i=0; i<events.size(); ++i) {
+        if ((int)i == num_queue || events[i] == NULL) continue;
+        // events of other queues may only be waited on once submitted
+        clFlush(queues[i]);
+        wait_list.push_back(events[i]);
+    }
+    return wait_list;
+}
+
+// Takes ownership of the event
+void HipaccContext::add_event(int num_queue, cl_event event) {
+    if (!async) {
+        clReleaseEvent(event);
+        return;
+    }
+    if (events[num_queue]) clReleaseEvent(events[num_queue]);
+    events[num_queue] = event;
+}
+
+void HipaccContext::add_host_write(cl_mem mem, cl_event event) {
+    if (!async) return;
+    wait_host_write(mem);
+    clRetainEvent(event);
+    host_writes[mem] = event;
+}
+
+// Wait until the host copy of a memory object may be modified again
+void HipaccContext::wait_host_write(cl_mem mem) {
+    auto it = host_writes.find(mem);
+    if (it == host_writes.end()) return;
+
+    cl_int err = clWaitForEvents(1, &it->second);
+    err |= clReleaseEvent(it->second);
+    checkErr(err, "clWaitForEvents()");
+    host_writes.erase(it);
+}
+
+void HipaccContext::set_multi_device(bool enable) {
+    multi_device = enable;
+    if (!enable) return;
+
+    // sub-buffer origins have to be aligned for every device of the context
+    device_units.clear();
+    for (auto device : devices_all) {
+        cl_uint align_bits = 0, compute_units = 1;
+        clGetDeviceInfo(device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(align_bits), &align_bits, NULL);
+        clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, NULL);
+        sub_buffer_align = std::max<size_t>(sub_buffer_align, align_bits/8);
+        device_units.push_back(compute_units);
+    }
+}
+
+bool HipaccContext::is_multi_device() {
+    return multi_device && queues.size() > 1;
+}
+
+void HipaccContext::set_sub_devices(std::vector<cl_device_id> ids) {
+    devices.assign(1, ids[0]);
+    devices_all = ids;
+}
+
+size_t HipaccContext::get_sub_buffer_align() {
+    return sub_buffer_align;
+}
+
+std::vector<double> HipaccContext::get_device_units() {
+    return device_units;
+}
+
+// Block rows processed per ms on each device for a kernel, measured by
+// synchronous launches; 0 until a device has executed a band
+std::vector<double> &HipaccContext::get_device_rates(cl_kernel kernel) {
+    auto it = device_rates.find(kernel);
+    if (it != device_rates.end()) return it->second;
+
+    return device_rates[kernel] = std::vector<double>(devices_all.size(), 0);
+}
+
+void HipaccContext::set_kernel_bands(cl_kernel kernel, const hipacc_kernel_bands &bands) {
+    kernel_bands[kernel] = bands;
+}
+
+void HipaccContext::remove_kernel_bands(cl_kernel kernel) {
+    kernel_bands.erase(kernel);
+}
+
+hipacc_kernel_bands *HipaccContext::get_kernel_bands(cl_kernel kernel) {
+    auto it = kernel_bands.find(kernel);
+    if (it == kernel_bands.end()) return nullptr;
+    return &it->second;
+}
+
+void HipaccContext::add_tuned_kernel(const std::string &key, const hipacc_tuned_kernel &kernel) {
+    tuned_kernels[key] = kernel;
+}
+
+hipacc_tuned_kernel *HipaccContext::get_tuned_kernel(const std::string &key) {
+    auto it = tuned_kernels.find(key);
+    if (it == tuned_kernels.end()) return nullptr;
+    return &it->second;
+}
+
+void HipaccContext::synchronize() {
+    cl_int err = CL_SUCCESS;
+    for (auto queue : queues) err |= clFinish(queue);
+    for (auto &event : events) {
+        if (event) err |= clReleaseEvent(event);
+        event = NULL;
+    }
+    for (auto &write : host_writes) err |= clReleaseEvent(write.second);
+    host_writes.clear();
+    checkErr(err, "clFinish()");
+}
+
 HipaccImageOpenCL::HipaccImageOpenCL(size_t width, size_t height, 
     size_t stride, size_t alignment, size_t pixel_size, cl_mem mem,
     hipaccMemoryType mem_type)
@@ -187,6 +327,8 @@ HipaccImageOpenCL::HipaccImageOpenCL(size_t width, size_t height,
 }
 
 HipaccImageOpenCL::~HipaccImageOpenCL() {
+    // the host copy is freed by the base class
+    HipaccContext::getInstance().wait_host_write(mem);
     cl_int err = clReleaseMemObject(mem);
     checkErr(err, "clReleaseMemObject()");
 }
@@ -362,8 +504,47 @@ void hipaccCreateContextsAndCommandQueues(bool all_devies) {
     cl_command_queue command_queue;
     HipaccContext &Ctx = HipaccContext::getInstance();
 
+    const char *multi_device_env = getenv("HIPACC_CL_MULTI_DEVICE");
+    bool multi_device = multi_device_env && std::string(multi_device_env) == "1";
+
+    #ifdef CL_VERSION_1_2
+    // partition the device into sub-devices of equal size, e.g. to split
+    // kernels across the cores of a CPU
+    const char *sub_devices = getenv("HIPACC_CL_SUB_DEVICES");
+    if (sub_devices && atoi(sub_devices) > 1) {
+        cl_device_id device = Ctx.get_devices()[0];
+        cl_uint compute_units = 0, num_sub_devices = 0;
+        err = clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, NULL);
+        checkErr(err, "clGetDeviceInfo()");
+
+        cl_uint units = std::max<cl_uint>(1, compute_units / atoi(sub_devices));
+        cl_device_partition_property props[3] = { CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property)units, 0 };
+        err = clCreateSubDevices(device, props, 0, NULL, &num_sub_devices);
+        if (err == CL_SUCCESS && num_sub_devices > 0) {
+            std::vector<cl_device_id> ids(num_sub_devices);
+            err = clCreateSubDevices(device, props, ids.size(), ids.data(), NULL);
+            checkErr(err, "clCreateSubDevices()");
+            Ctx.set_sub_devices(ids);
+            std::cerr << "<HIPACC:> Using " << ids.size() << " sub-devices with "
+                      << units << " compute units each" << std::endl;
+        } else {
+            std::cerr << "<HIPACC:> Partitioning into sub-devices failed: "
+                      << getOpenCLErrorCodeStr(err) << std::endl;
+        }
+    }
+    #endif
+
+    #ifndef CL_VERSION_1_2
+    // bands are passed as sub-buffers and migrated to their device
+    if (multi_device) {
+        std::cerr << "<HIPACC:> Multi-device execution requires OpenCL 1.2, using a single device" << std::endl;
+        multi_device = false;
+    }
+    #endif
+    Ctx.set_multi_device(multi_device);
+
     std::vector<cl_platform_id> platforms = Ctx.get_platforms();
-    std::vector<cl_device_id> devices = all_devies?Ctx.get_devices_all():Ctx.get_devices();
+    std::vector<cl_device_id> devices = (all_devies || multi_device)?Ctx.get_devices_all():Ctx.get_devices();
 
     // Create context
     cl_context_properties cprops[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)platforms[0], 0 };
@@ -385,6 +566,22 @@ void hipaccCreateContextsAndCommandQueues(bool all_devies) {
 
         Ctx.add_command_queue(command_queue);
     }
+
+    const char *async = getenv("HIPACC_CL_ASYNC");
+    if (async && std::string(async) == "1") Ctx.set_async(true);
+}
+
+
+// Enable or disable asynchronous command submission: kernel launches, copies
+// and writes return immediately and only host reads synchronize
+void hipaccSetAsync(bool enable) {
+    HipaccContext::getInstance().set_async(enable);
+}
+
+
+// Wait for all commands enqueued in asynchronous mode
+void hipaccSynchronize() {
+    HipaccContext::getInstance().synchronize();
 }
 
 
@@ -428,6 +625,155 @@ void hipaccDumpBinary(cl_program program, cl_device_id device) {
 }
 
 
+// Directory of the program binary cache, empty if caching is disabled
+std::string hipaccBinaryCacheDir() {
+    const char *enabled = getenv("HIPACC_CL_BINARY_CACHE");
+    if (enabled && std::string(enabled) == "0") return std::string();
+
+    const char *dir = getenv("HIPACC_CL_CACHE_DIR");
+    return dir && *dir ? std::string(dir) : std::string("hipacc_cl_cache");
+}
+
+
+// Cache file of a program binary: the build is determined by the runtime
+// version, the source and the headers it includes, the build options, and the
+// name and driver of each device in the context
+std::string hipaccBinaryCacheFile(std::string file_name, const std::string &source, const std::string &build_options, std::vector<cl_device_id> &devices) {
+    std::string dir = hipaccBinaryCacheDir();
+    if (dir.empty()) return std::string();
+
+    std::string key = std::string(HIPACC_CL_RUNTIME_VERSION) + '\n' + source + '\n' + build_options;
+
+    // headers are searched relative to the source and in the -I directories
+    std::vector<std::string> include_dirs;
+    size_t pos = file_name.find_last_of("/\\");
+    include_dirs.push_back(pos == std::string::npos ? std::string(".") : file_name.substr(0, pos));
+    std::istringstream options(build_options);
+    std::string option;
+    while (options >> option) {
+        if (option == "-I") {
+            if (options >> option) include_dirs.push_back(option);
+        } else if (option.compare(0, 2, "-I") == 0) {
+            include_dirs.push_back(option.substr(2));
+        }
+    }
+    hipaccAppendIncludes(key, source, include_dirs);
+
+    for (auto device : devices) {
+        char device_name[1024], driver_version[1024];
+        cl_int err = clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(device_name), &device_name, NULL);
+        err |= clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(driver_version), &driver_version, NULL);
+        checkErr(err, "clGetDeviceInfo()");
+        key += '\n' + std::string(device_name) + '\n' + driver_version;
+    }
+
+    if (pos != std::string::npos) file_name = file_name.substr(pos + 1);
+
+    return dir + "/" + file_name + "-" + hipaccTuningHash(key) + ".bin";
+}
+
+
+// Devices of the context programs are built for
+std::vector<cl_device_id> hipaccGetContextDevices() {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_uint num_devices = 0;
+    cl_int err = clGetContextInfo(Ctx.get_contexts()[0], CL_CONTEXT_NUM_DEVICES, sizeof(cl_uint), &num_devices, NULL);
+    std::vector<cl_device_id> devices(num_devices);
+    err |= clGetContextInfo(Ctx.get_contexts()[0], CL_CONTEXT_DEVICES, devices.size() * sizeof(cl_device_id), devices.data(), NULL);
+    checkErr(err, "clGetContextInfo()");
+
+    return devices;
+}
+
+
+// Create and build program from cached binaries, returns NULL on cache miss or
+// if the driver rejects the binaries
+cl_program hipaccLoadProgramBinary(const std::string &cache_file, std::vector<cl_device_id> &devices, const std::string &build_options) {
+    std::ifstream file(cache_file.c_str(), std::ios::binary);
+    if (!file.is_open()) return NULL;
+
+    // file layout: per device the binary size followed by the binary
+    std::vector<std::vector<unsigned char>> binaries(devices.size());
+    std::vector<size_t> binary_sizes(devices.size());
+    std::vector<const unsigned char *> binary_ptrs(devices.size());
+    for (size_t i=0; i<devices.size(); ++i) {
+        uint64_t size = 0;
+        if (!file.read(reinterpret_cast<char *>(&size), sizeof(size)) || !size) return NULL;
+        binaries[i].resize(size);
+        if (!file.read(reinterpret_cast<char *>(binaries[i].data()), size)) return NULL;
+        binary_sizes[i] = size;
+        binary_ptrs[i] = binaries[i].data();
+    }
+
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    cl_int err = CL_SUCCESS;
+    std::vector<cl_int> binary_status(devices.size());
+    cl_program program = clCreateProgramWithBinary(Ctx.get_contexts()[0], devices.size(), devices.data(), binary_sizes.data(), binary_ptrs.data(), binary_status.data(), &err);
+    if (err != CL_SUCCESS) return NULL;
+
+    err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+    if (err != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+
+// Write the binaries of a built program to the cache; the file is written
+// under a temporary name and renamed so that concurrent runs never read a
+// partially written binary
+void hipaccStoreProgramBinary(const std::string &cache_file, cl_program program, std::vector<cl_device_id> &devices) {
+    std::string dir = hipaccBinaryCacheDir();
+    #ifdef _WIN32
+    _mkdir(dir.c_str());
+    #else
+    mkdir(dir.c_str(), 0755);
+    #endif
+
+    cl_uint num_devices = 0;
+    cl_int err = clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &num_devices, NULL);
+    std::vector<cl_device_id> program_devices(num_devices);
+    err |= clGetProgramInfo(program, CL_PROGRAM_DEVICES, program_devices.size() * sizeof(cl_device_id), program_devices.data(), NULL);
+    std::vector<size_t> binary_sizes(num_devices);
+    err |= clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, binary_sizes.size() * sizeof(size_t), binary_sizes.data(), NULL);
+    if (err != CL_SUCCESS) return;
+
+    std::vector<std::vector<unsigned char>> binaries(num_devices);
+    std::vector<unsigned char *> binary_ptrs(num_devices);
+    for (size_t i=0; i<binaries.size(); ++i) {
+        if (!binary_sizes[i]) return;
+        binaries[i].resize(binary_sizes[i]);
+        binary_ptrs[i] = binaries[i].data();
+    }
+    err = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char *)*binary_ptrs.size(), binary_ptrs.data(), NULL);
+    if (err != CL_SUCCESS) return;
+
+    std::string tmp_file = hipaccTempFile(cache_file);
+    std::ofstream file(tmp_file.c_str(), std::ios::binary);
+    if (tmp_file.empty() || !file.is_open()) {
+        std::cerr << "<HIPACC:> Can't write OpenCL binary cache file '" << cache_file << "'" << std::endl;
+        if (!tmp_file.empty()) std::remove(tmp_file.c_str());
+        return;
+    }
+    // store binaries in the device order of the context
+    for (auto device : devices) {
+        for (size_t i=0; i<program_devices.size(); ++i) {
+            if (program_devices[i] != device) continue;
+            uint64_t size = binary_sizes[i];
+            file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char *>(binaries[i].data()), size);
+        }
+    }
+    file.close();
+
+    if (!file || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+        std::remove(tmp_file.c_str());
+    }
+}
+
+
 // Load OpenCL source file, build program, and create kernel
 cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_name, bool print_progress, bool dump_binary, bool print_log, std::string build_options, std::string build_includes) {
     cl_int err = CL_SUCCESS;
@@ -444,12 +790,7 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     std::string clString(std::istreambuf_iterator<char>(srcFile),
             (std::istreambuf_iterator<char>()));
 
-    const size_t length = clString.length();
-    const char *c_str = clString.c_str();
-
     if (print_progress) std::cerr << "<HIPACC:> Compiling '" << kernel_name << "' .";
-    program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
-    checkErr(err, "clCreateProgramWithSource()");
 
     cl_platform_name platform_name = Ctx.get_platform_names()[0];
     if (build_options.empty()) {
@@ -474,7 +815,25 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     if (!build_includes.empty()) {
         build_options += " " + build_includes;
     }
-    err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+
+    // reuse binaries of a previous build with identical source and options
+    std::vector<cl_device_id> devices = hipaccGetContextDevices();
+    std::string cache_file = hipaccBinaryCacheFile(file_name, clString, build_options, devices);
+    bool cached = false;
+    if (!cache_file.empty() && !dump_binary) {
+        program = hipaccLoadProgramBinary(cache_file, devices, build_options);
+        cached = program != NULL;
+    }
+
+    if (!cached) {
+        const size_t length = clString.length();
+        const char *c_str = clString.c_str();
+
+        program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
+        checkErr(err, "clCreateProgramWithSource()");
+
+        err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+    }
     if (print_progress) std::cerr << ".";
 
     cl_build_status build_status;
@@ -509,6 +868,8 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     }
     checkErr(err, "clBuildProgram(), clGetProgramBuildInfo()");
 
+    if (!cached && !cache_file.empty()) hipaccStoreProgramBinary(cache_file, program, devices);
+
     if (dump_binary) hipaccDumpBinary(program, Ctx.get_devices()[0]);
 
     kernel = clCreateKernel(program, kernel_name.c_str(), &err);
@@ -572,6 +933,8 @@ cl_sampler hipaccCreateSampler(cl_bool normalized_coords, cl_addressing_mode add
 void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst, int num_device) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(num_device);
+    cl_event event;
 
     assert(src->width == dst->width && src->height == dst->height && src->pixel_size == dst->pixel_size && "Invalid CopyBuffer or CopyImage!");
 
@@ -579,12 +942,14 @@ void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst, int num_device)
         const size_t origin[] = { 0, 0, 0 };
         const size_t region[] = { src->width, src->height, 1 };
 
-        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src->mem, (cl_mem)dst->mem, origin, origin, region, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src->mem, (cl_mem)dst->mem, origin, origin, region, wait_list.size(), hipaccEventList(wait_list), &event);
+        Ctx.add_event(num_device, event);
+        if (!Ctx.is_async()) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyImage()");
     } else {
-        err = clEnqueueCopyBuffer(Ctx.get_command_queues()[num_device], (cl_mem)src->mem, (cl_mem)dst->mem, 0, 0, src->stride*src->height*src->pixel_size, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueCopyBuffer(Ctx.get_command_queues()[num_device], (cl_mem)src->mem, (cl_mem)dst->mem, 0, 0, src->stride*src->height*src->pixel_size, wait_list.size(), hipaccEventList(wait_list), &event);
+        Ctx.add_event(num_device, event);
+        if (!Ctx.is_async()) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyBuffer()");
     }
 }
@@ -594,14 +959,17 @@ void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst, int num_device)
 void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst, int num_device) {
     cl_int err = CL_SUCCESS;
     HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(num_device);
+    cl_event event;
 
     if (src.img->mem_type >= Array2D) {
         const size_t dst_origin[] = { (size_t)dst.offset_x, (size_t)dst.offset_y, 0 };
         const size_t src_origin[] = { (size_t)src.offset_x, (size_t)src.offset_y, 0 };
         const size_t region[]     = { dst.width, dst.height, 1 };
 
-        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src.img->mem, (cl_mem)dst.img->mem, src_origin, dst_origin, region, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+        err = clEnqueueCopyImage(Ctx.get_command_queues()[num_device], (cl_mem)src.img->mem, (cl_mem)dst.img->mem, src_origin, dst_origin, region, wait_list.size(), hipaccEventList(wait_list), &event);
+        Ctx.add_event(num_device, event);
+        if (!Ctx.is_async()) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyImage()");
     } else {
         const size_t dst_origin[] = { dst.offset_x*dst.img->pixel_size, (size_t)dst.offset_y, 0 };
@@ -609,8 +977,9 @@ void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst
         const size_t region[]     = { dst.width*dst.img->pixel_size, dst.height, 1 };
 
         err = clEnqueueCopyBufferRect(Ctx.get_command_queues()[num_device], (cl_mem)src.img->mem, (cl_mem)dst.img->mem, src_origin, dst_origin, region,
-                                      src.img->stride*src.img->pixel_size, 0, dst.img->stride*dst.img->pixel_size, 0, 0, NULL, NULL);
-        err |= clFinish(Ctx.get_command_queues()[num_device]);
+                                      src.img->stride*src.img->pixel_size, 0, dst.img->stride*dst.img->pixel_size, 0, wait_list.size(), hipaccEventList(wait_list), &event);
+        Ctx.add_event(num_device, event);
+        if (!Ctx.is_async()) err |= clFinish(Ctx.get_command_queues()[num_device]);
         checkErr(err, "clEnqueueCopyBufferRect()");
     }
 }
@@ -670,6 +1039,196 @@ double hipaccCopyBufferBenchmark(const HipaccImage &src, HipaccImage &dst, int n
 }
 
 
+// Read from a buffer and wait only for this read and the commands it depends on
+void hipaccReadBufferSync(cl_mem mem, size_t size, void *host_mem, int num_device) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(num_device);
+    cl_event event;
+
+    cl_int err = clEnqueueReadBuffer(Ctx.get_command_queues()[num_device], mem, CL_FALSE, 0, size, host_mem, wait_list.size(), hipaccEventList(wait_list), &event);
+    err |= clWaitForEvents(1, &event);
+    err |= clReleaseEvent(event);
+    checkErr(err, "clEnqueueReadBuffer()");
+}
+
+
+// Describe an image buffer of a kernel for hipaccSetKernelBands
+hipacc_band_arg hipaccBandArg(int mem_arg, int band_arg, const HipaccAccessor &acc, int halo, bool output) {
+    hipacc_band_arg arg;
+    arg.mem_arg = mem_arg;
+    arg.band_arg = band_arg;
+    arg.mem = (cl_mem)acc.img->mem;
+    arg.pitch = acc.img->stride * acc.img->pixel_size;
+    arg.height = acc.img->height;
+    arg.offset_y = acc.offset_y;
+    arg.rows = acc.height;
+    arg.halo = halo;
+    arg.output = output;
+    return arg;
+}
+
+
+// Register the image buffers of a kernel so that its rows can be split across
+// devices; kernels reading the image they write are not split
+void hipaccSetKernelBands(cl_kernel kernel, int pixels_per_thread, std::vector<hipacc_band_arg> args) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+
+    cl_mem output = NULL;
+    for (auto &arg : args) {
+        if (arg.output) output = arg.mem;
+    }
+    for (auto &arg : args) {
+        if (!output || (!arg.output && arg.mem == output)) {
+            Ctx.remove_kernel_bands(kernel);
+            return;
+        }
+    }
+
+    hipacc_kernel_bands bands = { pixels_per_thread, args };
+    Ctx.set_kernel_bands(kernel, bands);
+}
+
+
+#ifdef CL_VERSION_1_2
+// Largest row not after row at which a sub-buffer may start
+static size_t hipaccAlignRow(size_t row, size_t pitch, size_t align) {
+    while (row && (row*pitch) % align) --row;
+    return row;
+}
+
+
+// Split the rows of the iteration space across all devices of the context in
+// proportion to their measured throughput. Each device gets sub-buffers of
+// its output rows and of the input rows it reads including the halo; the
+// sub-buffers are migrated to the device before the band is launched.
+void hipaccLaunchKernelMultiDevice(cl_kernel kernel, const hipacc_kernel_bands &bands, size_t *global_work_size, size_t *local_work_size, bool print_timing) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_command_queue> queues = Ctx.get_command_queues();
+    std::vector<double> &rates = Ctx.get_device_rates(kernel);
+    size_t align = Ctx.get_sub_buffer_align();
+
+    const hipacc_band_arg *out = NULL;
+    for (auto &arg : bands.args) {
+        if (arg.output) out = &arg;
+    }
+
+    // use the measured rates once every device has executed a band, the
+    // number of compute units before
+    std::vector<double> weights = rates;
+    for (auto rate : rates) {
+        if (rate <= 0) {
+            weights = Ctx.get_device_units();
+            break;
+        }
+    }
+    double total_weight = 0, weight = 0;
+    for (auto w : weights) total_weight += w;
+
+    // band boundaries in blocks, moved to the nearest block whose first output
+    // row can start a sub-buffer
+    size_t rows_per_block = local_work_size[1] * bands.pixels_per_thread;
+    size_t num_blocks = global_work_size[1] / local_work_size[1];
+    std::vector<size_t> bounds(queues.size()+1, num_blocks);
+    bounds[0] = 0;
+    for (size_t i=1; i<queues.size(); ++i) {
+        weight += weights[i-1];
+        double ideal = num_blocks * weight / total_weight;
+        for (size_t b=bounds[i-1]; b<num_blocks; ++b) {
+            bool valid = b == 0 || ((out->offset_y + b*rows_per_block)*out->pitch) % align == 0;
+            if (valid && std::abs(b - ideal) < std::abs(bounds[i] - ideal)) bounds[i] = b;
+        }
+    }
+
+    std::vector<cl_event> wait_list = Ctx.get_wait_list(-1);
+    std::vector<cl_event> events(queues.size(), NULL);
+    cl_int err = CL_SUCCESS;
+    for (size_t i=0; i<queues.size(); ++i) {
+        if (bounds[i] == bounds[i+1]) continue;
+        size_t r0 = bounds[i]*rows_per_block;
+        size_t r1 = std::min<size_t>(bounds[i+1]*rows_per_block, out->rows);
+
+        // inputs read entirely are passed as they are
+        std::vector<cl_mem> mems, sub_buffers;
+        for (auto &arg : bands.args) {
+            cl_mem mem = arg.mem;
+            int band_y = 0;
+            if (arg.output || arg.halo >= 0) {
+                size_t halo = arg.output ? 0 : arg.halo;
+                size_t first = arg.offset_y + r0 < halo ? 0 : arg.offset_y + r0 - halo;
+                size_t last = std::min(arg.height, arg.offset_y + r1 + halo);
+                first = hipaccAlignRow(first, arg.pitch, align);
+                cl_buffer_region region = { first*arg.pitch, (last-first)*arg.pitch };
+                mem = clCreateSubBuffer(arg.mem, 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+                checkErr(err, "clCreateSubBuffer()");
+                sub_buffers.push_back(mem);
+                band_y = first;
+            }
+            err = clSetKernelArg(kernel, arg.mem_arg, sizeof(cl_mem), &mem);
+            if (arg.band_arg >= 0) err |= clSetKernelArg(kernel, arg.band_arg, sizeof(int), &band_y);
+            checkErr(err, "clSetKernelArg()");
+            if (std::find(mems.begin(), mems.end(), mem) == mems.end()) mems.push_back(mem);
+        }
+
+        // halo exchange: copy the rows of the band, including the rows
+        // written by the neighbours, to the device
+        cl_event migrated;
+        err = clEnqueueMigrateMemObjects(queues[i], mems.size(), mems.data(), 0, wait_list.size(), hipaccEventList(wait_list), &migrated);
+        checkErr(err, "clEnqueueMigrateMemObjects()");
+
+        size_t offset[2] = { 0, bounds[i]*local_work_size[1] };
+        size_t size[2] = { global_work_size[0], (bounds[i+1]-bounds[i])*local_work_size[1] };
+        err = clEnqueueNDRangeKernel(queues[i], kernel, 2, offset, size, local_work_size, 1, &migrated, &events[i]);
+        err |= clFlush(queues[i]);
+        err |= clReleaseEvent(migrated);
+        checkErr(err, "clEnqueueNDRangeKernel()");
+
+        for (auto mem : sub_buffers) err |= clReleaseMemObject(mem);
+        checkErr(err, "clReleaseMemObject()");
+    }
+
+    // restore the arguments for launches on a single device
+    for (auto &arg : bands.args) {
+        int band_y = 0;
+        err |= clSetKernelArg(kernel, arg.mem_arg, sizeof(cl_mem), &arg.mem);
+        if (arg.band_arg >= 0) err |= clSetKernelArg(kernel, arg.band_arg, sizeof(int), &band_y);
+    }
+    checkErr(err, "clSetKernelArg()");
+
+    if (Ctx.is_async()) {
+        for (size_t i=0; i<queues.size(); ++i) {
+            if (events[i]) Ctx.add_event(i, events[i]);
+        }
+        return;
+    }
+
+    // update the rates from the execution time of each band
+    cl_ulong first_start = ~(cl_ulong)0, last_end = 0;
+    for (size_t i=0; i<queues.size(); ++i) {
+        if (!events[i]) continue;
+        cl_ulong start, end;
+        err = clWaitForEvents(1, &events[i]);
+        err |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, 0);
+        err |= clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, 0);
+        err |= clReleaseEvent(events[i]);
+        checkErr(err, "clGetEventProfilingInfo()");
+
+        double time = (end-start)*1.0e-6;
+        if (time > 0) {
+            double rate = (bounds[i+1]-bounds[i]) / time;
+            rates[i] = rates[i] > 0 ? 0.5*rates[i] + 0.5*rate : rate;
+        }
+        first_start = std::min(first_start, start);
+        last_end = std::max(last_end, end);
+    }
+
+    hipacc_last_timing = (last_end-first_start)*1.0e-6f;
+    if (print_timing) {
+        std::cerr << "<HIPACC:> Kernel timing (" << local_work_size[0]*local_work_size[1] << ": " << local_work_size[0] << "x" << local_work_size[1] << ", " << queues.size() << " devices): " << hipacc_last_timing << "(ms)" << std::endl;
+    }
+}
+#endif
+
+
 // Enqueue and launch kernel
 void hipaccLaunchKernel(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, bool print_timing) {
     cl_int err;
@@ -679,6 +1238,24 @@ void hipaccLaunchKernel(cl_kernel kernel, size_t *global_work_size, size_t *loca
     #endif
     HipaccContext &Ctx = HipaccContext::getInstance();
 
+    #ifdef CL_VERSION_1_2
+    hipacc_kernel_bands *bands = Ctx.get_kernel_bands(kernel);
+    if (Ctx.is_multi_device() && bands) {
+        hipaccLaunchKernelMultiDevice(kernel, *bands, global_work_size, local_work_size, print_timing);
+        return;
+    }
+    #endif
+
+    if (Ctx.is_async()) {
+        // no timing: the kernel may not even have started when we return
+        std::vector<cl_event> wait_list = Ctx.get_wait_list(0);
+        cl_event async_event;
+        err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, wait_list.size(), hipaccEventList(wait_list), &async_event);
+        checkErr(err, "clEnqueueNDRangeKernel()");
+        Ctx.add_event(0, async_event);
+        return;
+    }
+
     #ifdef EVENT_TIMING
     err = clEnqueueNDRangeKernel(Ctx.get_command_queues()[0], kernel, 2, NULL, global_work_size, local_work_size, 0, NULL, &event);
     err |= clFinish(Ctx.get_command_queues()[0]);
@@ -714,6 +1291,11 @@ void hipaccLaunchKernel(cl_kernel kernel, size_t *global_work_size, size_t *loca
 void hipaccLaunchKernelBenchmark(cl_kernel kernel, size_t *global_work_size, size_t *local_work_size, std::vector<std::pair<size_t, void *> > args, bool print_timing) {
     std::vector<float> times;
 
+    // timing requires synchronous launches
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    bool async = Ctx.is_async();
+    Ctx.set_async(false);
+
     for (size_t i=0; i<HIPACC_NUM_ITERATIONS; ++i) {
         // set kernel arguments
         for (size_t j=0; j<args.size(); ++j)
@@ -723,6 +1305,8 @@ void hipaccLaunchKernelBenchmark(cl_kernel kernel, size_t *global_work_size, siz
         times.push_back(hipacc_last_timing);
     }
 
+    Ctx.set_async(async);
+
     std::sort(times.begin(), times.end());
     hipacc_last_timing = times[times.size()/2];
 
@@ -736,6 +1320,25 @@ void hipaccLaunchKernelBenchmark(cl_kernel kernel, size_t *global_work_size, siz
 }
 
 
+// Key of an explored kernel in the tuning database: kernel, iteration space
+// and device form the scope, kernel source and driver version the version
+void hipaccTuningKey(std::string filename, std::string kernel, hipacc_launch_info &info, std::string &scope, std::string &version) {
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    char device_name[1024], driver_version[1024];
+    cl_int err = clGetDeviceInfo(Ctx.get_devices()[0], CL_DEVICE_NAME, sizeof(device_name), &device_name, NULL);
+    err |= clGetDeviceInfo(Ctx.get_devices()[0], CL_DRIVER_VERSION, sizeof(driver_version), &driver_version, NULL);
+    checkErr(err, "clGetDeviceInfo()");
+
+    std::ifstream srcFile(filename.c_str());
+    std::string source(std::istreambuf_iterator<char>(srcFile),
+            (std::istreambuf_iterator<char>()));
+
+    scope = kernel + ":" + std::to_string(info.is_width) + "x" +
+            std::to_string(info.is_height) + ":" + device_name;
+    version = hipaccTuningHash(source) + ":" + driver_version;
+}
+
+
 // Perform configuration exploration for a kernel call
 void hipaccLaunchKernelExploration(std::string filename, std::string kernel,
         std::vector<std::pair<size_t, void *>> args,
@@ -744,11 +1347,52 @@ void hipaccLaunchKernelExploration(std::string filename, std::string kernel,
         max_smem_per_block, int heu_tx, int heu_ty) {
     int opt_tx=warp_size, opt_ty=1;
     float opt_time = FLT_MAX;
+    HipaccContext &Ctx = HipaccContext::getInstance();
+
+    // launch configuration found by a previous exploration: the kernel is
+    // built once per process and reused by later launches
+    std::string tuned_key = filename + ":" + kernel + ":" +
+                            std::to_string(info.is_width) + "x" +
+                            std::to_string(info.is_height);
+    hipacc_tuned_kernel *tuned_kernel = Ctx.get_tuned_kernel(tuned_key);
+    std::string tuning_scope, tuning_version;
+    if (!tuned_kernel) {
+        hipaccTuningKey(filename, kernel, info, tuning_scope, tuning_version);
+        std::vector<int> tuned;
+        if (hipaccTuningLookup(tuning_scope, tuning_version, tuned) && tuned.size() == 2 &&
+            tuned[0] > 0 && tuned[1] > 0) {
+            std::cerr << "<HIPACC:> Using tuned configuration for kernel '" << kernel
+                      << "': " << tuned[0]*tuned[1] << " (" << tuned[0] << "x" << tuned[1]
+                      << ")" << std::endl;
+
+            std::string compile_options =
+                " -D BSX_EXPLORE=" + std::to_string(tuned[0]) +
+                " -D BSY_EXPLORE=" + std::to_string(tuned[1]) +
+                " -I./include ";
+            hipacc_tuned_kernel built = { hipaccBuildProgramAndKernel(filename, kernel, false, false, false, compile_options), tuned[0], tuned[1] };
+            Ctx.add_tuned_kernel(tuned_key, built);
+            tuned_kernel = Ctx.get_tuned_kernel(tuned_key);
+        }
+    }
+
+    if (tuned_kernel) {
+        size_t local_work_size[2] = { (size_t)tuned_kernel->tile_size_x, (size_t)tuned_kernel->tile_size_y };
+        size_t global_work_size[2];
+        hipaccCalcGridFromBlock(info, local_work_size, global_work_size);
+        hipaccPrepareKernelLaunch(info, local_work_size);
+        for (size_t j=0; j<args.size(); ++j)
+            hipaccSetKernelArg(tuned_kernel->kernel, j, args[j].first, args[j].second);
+        hipaccLaunchKernel(tuned_kernel->kernel, global_work_size, local_work_size, false);
+        return;
+    }
 
     std::cerr << "<HIPACC:> Exploring configurations for kernel '" << kernel
               << "': configuration provided by heuristic " << heu_tx*heu_ty
               << " (" << heu_tx << "x" << heu_ty << "). " << std::endl;
 
+    bool async = Ctx.is_async();
+    Ctx.set_async(false);
+
     for (int tile_size_x=warp_size; tile_size_x<=max_threads_per_block; tile_size_x+=warp_size) {
         for (int tile_size_y=1; tile_size_y<=max_threads_per_block; ++tile_size_y) {
             // check if we exceed maximum number of threads
@@ -818,6 +1462,9 @@ void hipaccLaunchKernelExploration(std::string filename, std::string kernel,
     std::cerr << "<HIPACC:> Best configurations for kernel '" << kernel << "': "
               << opt_tx*opt_ty << " (" << opt_tx << "x" << opt_ty << "): "
               << opt_time << " ms" << std::endl;
+
+    hipaccTuningStore(tuning_scope, tuning_version, { opt_tx, opt_ty }, opt_time);
+    Ctx.set_async(async);
 }
 
 
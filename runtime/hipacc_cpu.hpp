@@ -26,33 +26,60 @@
 #ifndef __HIPACC_CPU_HPP__
 #define __HIPACC_CPU_HPP__
 
+#include <cfloat>
 #include <cmath>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <string>
 
 #include "hipacc_base.hpp"
 
+#ifdef USE_OPENMP
+# include <omp.h>
+#endif
+
 class HipaccContext : public HipaccContextBase {
     public:
         static HipaccContext &getInstance();
 };
 
+// alignment of pyramid levels within their arena (one cache line)
+#ifndef HIPACC_PYRAMID_ARENA_ALIGNMENT
+# define HIPACC_PYRAMID_ARENA_ALIGNMENT 64
+#endif
+
 class HipaccImageCPU : public HipaccImageBase {
     private:
         char *mem;
+        // memory shared by several images, e.g. the levels of a pyramid
+        std::shared_ptr<char> arena;
     public:
         HipaccImageCPU(size_t width, size_t height, size_t stride,
                        size_t alignment, size_t pixel_size, void* mem,
-                       hipaccMemoryType mem_type=Global);
+                       hipaccMemoryType mem_type=Global,
+                       std::shared_ptr<char> arena=nullptr);
         ~HipaccImageCPU();
 };
 
+// tile of the iteration space processed by one call of an explored kernel
+struct hipacc_cpu_tile {
+    int start_x, end_x, start_y, end_y;
+};
+
+// configuration of explored kernels: tiles of tile_x x tile_y pixels are
+// distributed dynamically among the given number of threads
+struct hipacc_cpu_config {
+    int threads, tile_x, tile_y;
+};
+
 extern int64_t start_time;
 extern int64_t end_time;
 
 
 void hipaccStartTiming();
-void hipaccStopTiming();
+void hipaccStopTiming(const char *kernel_name=nullptr, size_t width=0, size_t height=0,
+                      unsigned ops_per_pixel=0, unsigned bytes_per_pixel=0);
 void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst);
 void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst);
 
@@ -69,6 +96,16 @@ template<typename T>
 T *hipaccReadMemory(const HipaccImage &img);
 template<typename T>
 void hipaccWriteDomainFromMask(HipaccImage &dom, T* host_mem);
+template<typename T>
+HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height);
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth);
+template<typename Kernel>
+void hipaccLaunchKernelCPU(Kernel &kernel, size_t width, size_t height, const hipacc_cpu_config &config);
+template<typename Kernel>
+hipacc_cpu_config hipaccExploreKernelCPU(const char *kernel_name, Kernel &kernel, size_t width, size_t height);
+template<typename Kernel>
+void hipaccLaunchKernelExplorationCPU(const char *kernel_name, const char *source_hash, size_t width, size_t height, unsigned ops_per_pixel, unsigned bytes_per_pixel, Kernel kernel);
 
 
 #include "hipacc_cpu.tpp"
@@ -64,6 +64,7 @@ void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
     size_t width  = img->width;
     size_t height = img->height;
     size_t stride = img->stride;
+    HipaccTraceScope trace("hipaccWriteMemory", "copy", width, height);
 
     if ((char *)host_mem != img->host)
         std::copy(host_mem, host_mem + width*height, (T*)img->host);
@@ -84,6 +85,7 @@ T *hipaccReadMemory(const HipaccImage &img) {
     size_t width  = img->width;
     size_t height = img->height;
     size_t stride = img->stride;
+    HipaccTraceScope trace("hipaccReadMemory", "copy", width, height);
 
     if (stride > width) {
         for (size_t i=0; i<height; ++i) {
@@ -113,5 +115,177 @@ void hipaccWriteDomainFromMask(HipaccImage &dom, T* host_mem) {
 }
 
 
+// Allocate memory for Pyramid image
+template<typename T>
+HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height) {
+    if (base->alignment > 0) {
+        return hipaccCreateMemory<T>(NULL, width, height, base->alignment);
+    } else {
+        return hipaccCreateMemory<T>(NULL, width, height);
+    }
+}
+
+
+// Allocate all Pyramid levels below the base image within a single arena:
+// levels are placed back to back in traversal order, each starting at a
+// cache line boundary
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth) {
+    std::vector<HipaccImage> levels;
+    if (depth < 2) return levels;
+
+    size_t alignment = base->alignment;
+    size_t level_alignment = std::max(alignment, (size_t)HIPACC_PYRAMID_ARENA_ALIGNMENT);
+    std::vector<size_t> widths, heights, strides, offsets;
+
+    size_t size = 0;
+    size_t width  = base->width  / 2;
+    size_t height = base->height / 2;
+    for (size_t i=1; i<depth; ++i) {
+        assert(width * height > 0 && "Pyramid stages too deep for image size");
+        size_t stride = width;
+        if (alignment > 0) {
+            // alignment has to be a multiple of sizeof(T)
+            size_t pixels = (size_t)ceilf((float)alignment/sizeof(T));
+            stride = (size_t)ceilf((float)width/pixels) * pixels;
+        }
+        size = (size + level_alignment - 1) / level_alignment * level_alignment;
+        widths.push_back(width);
+        heights.push_back(height);
+        strides.push_back(stride);
+        offsets.push_back(size);
+        size += sizeof(T)*stride*height;
+        width  /= 2;
+        height /= 2;
+    }
+
+    std::shared_ptr<char> arena(new char[size + level_alignment],
+                                std::default_delete<char[]>());
+    char *start = arena.get();
+    start += (level_alignment - (uintptr_t)start % level_alignment) % level_alignment;
+
+    for (size_t i=0; i<widths.size(); ++i) {
+        levels.push_back(std::make_shared<HipaccImageCPU>(widths[i], heights[i],
+                    strides[i], alignment, sizeof(T), start + offsets[i],
+                    Global, arena));
+    }
+    return levels;
+}
+
+
+// Launch kernel for all tiles of the iteration space
+template<typename Kernel>
+void hipaccLaunchKernelCPU(Kernel &kernel, size_t width, size_t height, const hipacc_cpu_config &config) {
+    int tiles_x = (int)((width + config.tile_x - 1) / config.tile_x);
+    int tiles_y = (int)((height + config.tile_y - 1) / config.tile_y);
+    int num_tiles = tiles_x * tiles_y;
+
+    #ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(config.threads) if(config.threads > 1)
+    #endif
+    for (int t=0; t<num_tiles; ++t) {
+        hipacc_cpu_tile tile;
+        tile.start_x = (t % tiles_x) * config.tile_x;
+        tile.end_x = std::min(tile.start_x + config.tile_x, (int)width);
+        tile.start_y = (t / tiles_x) * config.tile_y;
+        tile.end_y = std::min(tile.start_y + config.tile_y, (int)height);
+        kernel(tile);
+    }
+}
+
+
+// Benchmark thread counts and tile sizes, return the fastest configuration
+template<typename Kernel>
+hipacc_cpu_config hipaccExploreKernelCPU(const char *kernel_name, Kernel &kernel, size_t width, size_t height) {
+    int max_threads = 1;
+    #ifdef USE_OPENMP
+    max_threads = omp_get_max_threads();
+    #endif
+
+    std::vector<int> thread_counts, tile_widths, tile_heights;
+    for (int threads=1; threads<max_threads; threads*=2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+    // whole rows or column blocks fitting into the L1/L2 cache
+    tile_widths.push_back((int)width);
+    for (int tile_x : { 256, 64 })
+        if (tile_x < (int)width) tile_widths.push_back(tile_x);
+    for (int tile_y : { 1, 4, 16, 64 })
+        if (tile_y <= (int)height) tile_heights.push_back(tile_y);
+
+    std::cerr << "<HIPACC:> Exploring configurations for kernel '" << kernel_name
+              << "' (" << width << "x" << height << ")" << std::endl;
+
+    hipacc_cpu_config opt_config = { 1, (int)width, 1 };
+    float opt_time = FLT_MAX;
+    for (int threads : thread_counts) {
+        for (int tile_x : tile_widths) {
+            for (int tile_y : tile_heights) {
+                hipacc_cpu_config config = { threads, tile_x, tile_y };
+                std::vector<float> times;
+
+                for (size_t i=0; i<HIPACC_NUM_ITERATIONS; ++i) {
+                    int64_t start = hipacc_time_micro();
+                    hipaccLaunchKernelCPU(kernel, width, height, config);
+                    times.push_back((hipacc_time_micro() - start) * 1.0e-3f);
+                }
+
+                std::sort(times.begin(), times.end());
+                float time = times[times.size()/2];
+                if (time < opt_time) {
+                    opt_time = time;
+                    opt_config = config;
+                }
+
+                std::cerr << "<HIPACC:> Kernel config: " << std::setw(3) << threads
+                          << " threads, tile " << std::setw(5) << tile_x << "x"
+                          << std::setw(2) << std::left << tile_y << std::right << ": "
+                          << std::setw(8) << std::fixed << std::setprecision(4)
+                          << time << " | " << times.front() << " | " << times.back()
+                          << " (median(" << HIPACC_NUM_ITERATIONS << ") | minimum | maximum) ms" << std::endl;
+            }
+        }
+    }
+
+    hipacc_last_timing = opt_time;
+    std::cerr << "<HIPACC:> Best configuration for kernel '" << kernel_name << "': "
+              << opt_config.threads << " threads, tile " << opt_config.tile_x
+              << "x" << opt_config.tile_y << ": " << opt_time << " ms" << std::endl;
+
+    return opt_config;
+}
+
+
+// Launch kernel with the configuration from the tuning database; explore and
+// store the configuration if the kernel was not tuned for this image size,
+// CPU, and number of available threads before
+template<typename Kernel>
+void hipaccLaunchKernelExplorationCPU(const char *kernel_name, const char *source_hash, size_t width, size_t height, unsigned ops_per_pixel, unsigned bytes_per_pixel, Kernel kernel) {
+    int max_threads = 1;
+    #ifdef USE_OPENMP
+    max_threads = omp_get_max_threads();
+    #endif
+    std::string scope = std::string(kernel_name) + ":" + std::to_string(width) +
+                        "x" + std::to_string(height) + ":" + hipaccTuningCPUModel() +
+                        ":" + std::to_string(max_threads) + "t";
+
+    hipacc_cpu_config config;
+    std::vector<int> tuned;
+    if (hipaccTuningLookup(scope, source_hash, tuned) && tuned.size() == 3 &&
+        tuned[0] > 0 && tuned[1] > 0 && tuned[2] > 0) {
+        config = { tuned[0], tuned[1], tuned[2] };
+    } else {
+        config = hipaccExploreKernelCPU(kernel_name, kernel, width, height);
+        hipaccTuningStore(scope, source_hash,
+                          { config.threads, config.tile_x, config.tile_y },
+                          hipacc_last_timing);
+    }
+
+    hipaccStartTiming();
+    hipaccLaunchKernelCPU(kernel, width, height, config);
+    hipaccStopTiming(kernel_name, width, height, ops_per_pixel, bytes_per_pixel);
+}
+
+
 #endif  // __HIPACC_CPU_TPP__
 
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#ifndef __HIPACC_CPU_JIT_HPP__
+#define __HIPACC_CPU_JIT_HPP__
+
+// JIT compilation of C/C++ kernels (-emit-c99 -jit). The emitted kernel file
+// is compiled in-process at first launch: image sizes, strides, offsets,
+// border handling bounds, and non-constant masks are baked into the kernel
+// and machine code is generated for the host CPU. Scalar kernel members are
+// passed at launch, so changing them does not recompile the kernel. The row
+// length of the image parameters stays the one of the kernel file, as for
+// -emit-c99 without -jit; a new image resolution needs a new kernel file.
+// Each specialization is compiled once per process, at most
+// HIPACC_JIT_MAX_SPECIALIZATIONS (default 8) per kernel before a generic
+// version is used; the object code is also stored in HIPACC_JIT_CACHE_DIR
+// (default: hipacc_jit_cache in the working directory) unless
+// HIPACC_JIT_CACHE=0. Kernel files are looked up in HIPACC_KERNEL_DIR if set,
+// otherwise next to the executable and then in the working directory.
+
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// argument of a JIT compiled kernel
+struct hipacc_jit_arg {
+    enum Kind {
+        Pointer,    // passed at launch, e.g. image memory
+        Value,      // passed at launch, value of non-arithmetic type
+        Literal     // baked into the kernel
+    };
+    Kind kind;
+    const void *ptr;
+    // literal value or initializer list of a mask
+    std::string literal;
+    // element type of a mask baked into the kernel
+    std::string type;
+};
+
+// arithmetic types that can be baked into the kernel
+template<typename T> struct hipacc_jit_type { static const char *name() { return nullptr; } };
+#define HIPACC_JIT_TYPE(T) \
+    template<> struct hipacc_jit_type<T> { static const char *name() { return #T; } };
+HIPACC_JIT_TYPE(bool)
+HIPACC_JIT_TYPE(char)
+HIPACC_JIT_TYPE(signed char)
+HIPACC_JIT_TYPE(unsigned char)
+HIPACC_JIT_TYPE(short)
+HIPACC_JIT_TYPE(unsigned short)
+HIPACC_JIT_TYPE(int)
+HIPACC_JIT_TYPE(unsigned int)
+HIPACC_JIT_TYPE(long)
+HIPACC_JIT_TYPE(unsigned long)
+HIPACC_JIT_TYPE(long long)
+HIPACC_JIT_TYPE(unsigned long long)
+HIPACC_JIT_TYPE(float)
+HIPACC_JIT_TYPE(double)
+#undef HIPACC_JIT_TYPE
+
+
+// Exact source representation of a value: floating point values are printed
+// with enough digits to be parsed back to the same value
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, std::string>::type
+hipaccJITLiteral(const T &value) {
+    std::ostringstream literal;
+    literal << "(" << hipacc_jit_type<T>::name() << ")";
+    if (std::isnan(value)) {
+        literal << "__builtin_nan(\"\")";
+    } else if (std::isinf(value)) {
+        literal << (value < 0 ? "-" : "") << "__builtin_huge_val()";
+    } else {
+        literal << std::scientific
+                << std::setprecision(std::numeric_limits<T>::max_digits10)
+                << value << (std::is_same<T, float>::value ? "f" : "");
+    }
+    return literal.str();
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value, std::string>::type
+hipaccJITLiteral(const T &value) {
+    std::ostringstream literal;
+    literal << "(" << hipacc_jit_type<T>::name() << ")";
+    if (std::is_signed<T>::value) literal << (long long)value << "ll";
+    else literal << (unsigned long long)value << "ull";
+    return literal.str();
+}
+
+
+// size, stride, offset or bound of the iteration space: arithmetic values
+// are baked into the kernel
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, hipacc_jit_arg>::type
+hipaccJITArg(const T &value) {
+    if (!hipacc_jit_type<T>::name())
+        return { hipacc_jit_arg::Value, &value, "", "" };
+    return { hipacc_jit_arg::Literal, &value, hipaccJITLiteral(value), "" };
+}
+
+template<typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value, hipacc_jit_arg>::type
+hipaccJITArg(const T &value) {
+    return { hipacc_jit_arg::Value, &value, "", "" };
+}
+
+
+// scalar kernel member, passed at launch
+template<typename T>
+hipacc_jit_arg hipaccJITValue(const T &value) {
+    return { hipacc_jit_arg::Value, &value, "", "" };
+}
+
+
+// image memory
+inline hipacc_jit_arg hipaccJITPointer(const void *mem) {
+    return { hipacc_jit_arg::Pointer, mem, "", "" };
+}
+
+
+// non-constant mask: the coefficients at launch are baked into the kernel
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, hipacc_jit_arg>::type
+hipaccJITMask(const T *mem, size_t size) {
+    if (!hipacc_jit_type<T>::name())
+        return { hipacc_jit_arg::Pointer, mem, "", "" };
+    std::string literal("{ ");
+    for (size_t i=0; i<size; ++i) {
+        if (i) literal += ", ";
+        literal += hipaccJITLiteral(mem[i]);
+    }
+    literal += " }";
+    return { hipacc_jit_arg::Literal, mem, literal, hipacc_jit_type<T>::name() };
+}
+
+template<typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value, hipacc_jit_arg>::type
+hipaccJITMask(const T *mem, size_t) {
+    return { hipacc_jit_arg::Pointer, mem, "", "" };
+}
+
+
+// Compile the kernel of the given file for the arguments, unless compiled
+// before, and execute it
+void hipaccLaunchKernelJIT(const char *file_name, const char *kernel_name,
+                           const std::vector<hipacc_jit_arg> &args);
+
+
+#endif  // __HIPACC_CPU_JIT_HPP__
@@ -0,0 +1,539 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+// This is the standalone (header-only) Hipacc JIT runtime for C/C++ kernels,
+// it requires the Clang and LLVM libraries
+
+
+#include "hipacc_cpu_jit.hpp"
+
+
+#ifndef __HIPACC_CPU_JIT_STANDALONE_HPP__
+#define __HIPACC_CPU_JIT_STANDALONE_HPP__
+
+
+#include "hipacc_base.hpp"
+
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Basic/TargetOptions.h>
+#include <clang/CodeGen/CodeGenAction.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/IPO/PassManagerBuilder.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+
+// entry point of a specialization, called with the arguments passed at launch
+typedef void (*hipacc_jit_entry)(void **args);
+
+// each specialization lives in its own JIT instance, so that kernels and
+// helper functions of different specializations never collide
+struct hipacc_jit_kernel {
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    hipacc_jit_entry entry;
+};
+
+
+void hipaccJITError(const std::string &msg, llvm::Error err) {
+    std::cerr << "ERROR: " << msg << ": " << llvm::toString(std::move(err)) << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+
+// Directory of the machine code cache, empty if caching is disabled
+std::string hipaccJITCacheDir() {
+    const char *enabled = getenv("HIPACC_JIT_CACHE");
+    if (enabled && std::string(enabled) == "0") return std::string();
+
+    const char *dir = getenv("HIPACC_JIT_CACHE_DIR");
+    return dir && *dir ? std::string(dir) : std::string("hipacc_jit_cache");
+}
+
+
+// Path of a kernel file emitted by hipacc: relative paths are resolved in
+// HIPACC_KERNEL_DIR if set, otherwise next to the executable and finally in
+// the working directory
+std::string hipaccJITKernelFile(const std::string &file_name) {
+    if (llvm::sys::path::is_absolute(file_name)) return file_name;
+
+    llvm::SmallString<256> path;
+    if (const char *dir = getenv("HIPACC_KERNEL_DIR")) {
+        path = dir;
+        llvm::sys::path::append(path, file_name);
+        return path.str().str();
+    }
+
+    std::string executable = llvm::sys::fs::getMainExecutable(nullptr, (void *)&hipaccJITKernelFile);
+    if (!executable.empty()) {
+        path = llvm::sys::path::parent_path(executable);
+        llvm::sys::path::append(path, file_name);
+        if (llvm::sys::fs::exists(path)) return path.str().str();
+    }
+
+    return file_name;
+}
+
+
+// Name and features of the host CPU machine code is generated for
+void hipaccJITHostCPU(std::string &cpu, std::vector<std::string> &features) {
+    static std::string host_cpu;
+    static std::vector<std::string> host_features;
+    if (host_cpu.empty()) {
+        host_cpu = llvm::sys::getHostCPUName().str();
+        llvm::StringMap<bool> feature_map;
+        if (llvm::sys::getHostCPUFeatures(feature_map)) {
+            for (auto &feature : feature_map)
+                host_features.push_back((feature.second ? "+" : "-") + feature.first().str());
+            std::sort(host_features.begin(), host_features.end());
+        }
+    }
+    cpu = host_cpu;
+    features = host_features;
+}
+
+
+llvm::orc::JITTargetMachineBuilder hipaccJITTargetMachineBuilder() {
+    auto builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!builder) hipaccJITError("Can't detect host for JIT compilation", builder.takeError());
+
+    std::string cpu;
+    std::vector<std::string> features;
+    hipaccJITHostCPU(cpu, features);
+    builder->setCPU(cpu);
+    builder->addFeatures(features);
+    builder->setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
+
+    return std::move(*builder);
+}
+
+
+// Source of a specialization: the kernel file followed by an entry point that
+// calls the kernel with the baked arguments
+std::string hipaccJITSource(const std::string &file_name, const std::string &kernel_source, const std::string &kernel_name, const std::vector<hipacc_jit_arg> &args) {
+    std::string source("#include \"hipacc_cpu.hpp\"\n");
+    source += "#line 1 \"" + file_name + "\"\n";
+    source += kernel_source;
+    source += "\n\nnamespace {\n"
+              "struct hipacc_jit_ptr {\n"
+              "    void *ptr;\n"
+              "    template<typename T> operator T *() const { return (T *)ptr; }\n"
+              "};\n"
+              "struct hipacc_jit_val {\n"
+              "    void *ptr;\n"
+              "    template<typename T> operator T() const { return *(T *)ptr; }\n"
+              "};\n"
+              "}\n\n";
+
+    for (size_t i=0; i<args.size(); ++i) {
+        if (args[i].kind == hipacc_jit_arg::Literal && !args[i].type.empty()) {
+            source += "static const " + args[i].type + " hipacc_jit_mask";
+            source += std::to_string(i) + "[] = " + args[i].literal + ";\n";
+        }
+    }
+
+    source += "\nextern \"C\" void hipacc_jit_entry(void **args) {\n";
+    source += "    " + kernel_name + "(";
+    for (size_t i=0; i<args.size(); ++i) {
+        std::string index = std::to_string(i);
+        if (i) source += ", ";
+        switch (args[i].kind) {
+            case hipacc_jit_arg::Pointer:
+                source += "hipacc_jit_ptr{ args[" + index + "] }";
+                break;
+            case hipacc_jit_arg::Value:
+                source += "hipacc_jit_val{ args[" + index + "] }";
+                break;
+            case hipacc_jit_arg::Literal:
+                if (args[i].type.empty())
+                    source += args[i].literal;
+                else
+                    source += "hipacc_jit_ptr{ (void *)hipacc_jit_mask" + index + " }";
+                break;
+        }
+    }
+    source += ");\n}\n";
+
+    return source;
+}
+
+
+// Command line the specialization of a kernel file is parsed with, and the
+// directories its includes are searched in
+std::vector<std::string> hipaccJITOptions(const std::string &file_name, std::vector<std::string> &include_dirs) {
+    std::vector<std::string> options = { "clang++", "-x", "c++", "-std=c++11",
+                                         "-O3", "-w", "-Xclang",
+                                         "-disable-llvm-passes", "-c",
+                                         file_name };
+
+    // the directory of the kernel file, runtime headers: HIPACC_JIT_INCLUDE
+    // (separated by ':') and installation
+    std::string parent = llvm::sys::path::parent_path(file_name).str();
+    include_dirs.assign(1, parent.empty() ? std::string(".") : parent);
+    std::string includes;
+    if (const char *dirs = getenv("HIPACC_JIT_INCLUDE")) includes = dirs;
+    #ifdef HIPACC_JIT_INCLUDE_DIR
+    includes += std::string(includes.empty() ? "" : ":") + HIPACC_JIT_INCLUDE_DIR;
+    #endif
+    std::istringstream dirs(includes);
+    for (std::string dir; std::getline(dirs, dir, ':'); ) {
+        if (dir.empty()) continue;
+        options.push_back("-I" + dir);
+        include_dirs.push_back(dir);
+    }
+
+    // builtin headers of Clang
+    const char *resource_dir = getenv("HIPACC_JIT_RESOURCE_DIR");
+    #ifdef HIPACC_JIT_RESOURCE_DIR
+    if (!resource_dir) resource_dir = HIPACC_JIT_RESOURCE_DIR;
+    #endif
+    if (resource_dir) {
+        options.push_back("-resource-dir");
+        options.push_back(resource_dir);
+    }
+
+    return options;
+}
+
+
+// Parse the specialization in place of the kernel file, so that includes
+// relative to the kernel file are found
+std::unique_ptr<llvm::Module> hipaccJITParse(const std::string &file_name, const std::string &source, const std::vector<std::string> &options, llvm::LLVMContext &context) {
+    std::vector<const char *> argv;
+    for (auto &option : options) argv.push_back(option.c_str());
+
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diags =
+        clang::CompilerInstance::createDiagnostics(new clang::DiagnosticOptions());
+    std::shared_ptr<clang::CompilerInvocation> invocation =
+        clang::createInvocationFromCommandLine(argv, diags);
+    if (!invocation) return nullptr;
+
+    // generate code for the host CPU
+    std::string cpu;
+    std::vector<std::string> features;
+    hipaccJITHostCPU(cpu, features);
+    invocation->getTargetOpts().Triple = llvm::sys::getProcessTriple();
+    invocation->getTargetOpts().CPU = cpu;
+    invocation->getTargetOpts().FeaturesAsWritten = features;
+    invocation->getPreprocessorOpts().addRemappedFile(file_name,
+            llvm::MemoryBuffer::getMemBufferCopy(source, file_name).release());
+
+    clang::CompilerInstance compiler;
+    compiler.setInvocation(invocation);
+    compiler.createDiagnostics();
+
+    clang::EmitLLVMOnlyAction action(&context);
+    if (!compiler.ExecuteAction(action)) return nullptr;
+
+    return action.takeModule();
+}
+
+
+// Optimize the specialization and generate an object file
+std::unique_ptr<llvm::MemoryBuffer> hipaccJITCodegen(llvm::Module &module, llvm::TargetMachine &target) {
+    module.setDataLayout(target.createDataLayout());
+    module.setTargetTriple(target.getTargetTriple().str());
+
+    // only the entry point is visible: the kernel is inlined and the baked
+    // arguments are propagated into its body
+    for (auto &function : module) {
+        if (function.isDeclaration() || function.getName() == "hipacc_jit_entry")
+            continue;
+        function.setComdat(nullptr);
+        function.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+    for (auto &global : module.globals()) {
+        if (global.isDeclaration()) continue;
+        global.setComdat(nullptr);
+        global.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+
+    llvm::PassManagerBuilder builder;
+    builder.OptLevel = 3;
+    builder.SizeLevel = 0;
+    builder.Inliner = llvm::createFunctionInliningPass(3, 0, false);
+    builder.LoopVectorize = true;
+    builder.SLPVectorize = true;
+    builder.LibraryInfo = new llvm::TargetLibraryInfoImpl(target.getTargetTriple());
+    target.adjustPassManager(builder);
+
+    llvm::legacy::FunctionPassManager function_passes(&module);
+    function_passes.add(llvm::createTargetTransformInfoWrapperPass(target.getTargetIRAnalysis()));
+    builder.populateFunctionPassManager(function_passes);
+    llvm::legacy::PassManager module_passes;
+    module_passes.add(llvm::createTargetTransformInfoWrapperPass(target.getTargetIRAnalysis()));
+    builder.populateModulePassManager(module_passes);
+
+    function_passes.doInitialization();
+    for (auto &function : module) function_passes.run(function);
+    function_passes.doFinalization();
+    module_passes.run(module);
+
+    llvm::SmallVector<char, 0> object;
+    llvm::raw_svector_ostream OS(object);
+    llvm::legacy::PassManager codegen;
+    if (target.addPassesToEmitFile(codegen, OS, nullptr, llvm::TargetMachine::CGFT_ObjectFile))
+        return nullptr;
+    codegen.run(module);
+
+    return llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object.data(), object.size()), "hipacc_jit_object");
+}
+
+
+// Write an object file to the cache; the file is written under a temporary
+// name and renamed so that concurrent runs never read a partial object
+void hipaccJITStoreObject(const std::string &cache_file, const llvm::MemoryBuffer &object) {
+    std::string dir = hipaccJITCacheDir();
+    #ifdef _WIN32
+    _mkdir(dir.c_str());
+    #else
+    mkdir(dir.c_str(), 0755);
+    #endif
+
+    std::string tmp_file = hipaccTempFile(cache_file);
+    std::ofstream file(tmp_file.c_str(), std::ios::binary);
+    if (tmp_file.empty() || !file.is_open()) {
+        std::cerr << "<HIPACC:> Can't write JIT cache file '" << cache_file << "'" << std::endl;
+        if (!tmp_file.empty()) std::remove(tmp_file.c_str());
+        return;
+    }
+    file.write(object.getBufferStart(), object.getBufferSize());
+    file.close();
+
+    if (!file || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+        std::remove(tmp_file.c_str());
+    }
+}
+
+
+// Link an object file into a new JIT instance and look up its entry point
+hipacc_jit_kernel hipaccJITLoad(std::unique_ptr<llvm::MemoryBuffer> object) {
+    auto builder = hipaccJITTargetMachineBuilder();
+    auto target = builder.createTargetMachine();
+    if (!target) hipaccJITError("Can't create target machine", target.takeError());
+    llvm::DataLayout layout = (*target)->createDataLayout();
+
+    auto jit = llvm::orc::LLJIT::Create(std::move(builder), layout);
+    if (!jit) hipaccJITError("Can't create JIT", jit.takeError());
+
+    // math functions etc. are resolved in the running process
+    auto generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(layout);
+    if (!generator) hipaccJITError("Can't resolve process symbols", generator.takeError());
+    (*jit)->getMainJITDylib().setGenerator(std::move(*generator));
+
+    if (auto err = (*jit)->addObjectFile(std::move(object)))
+        hipaccJITError("Can't link JIT compiled kernel", std::move(err));
+    auto symbol = (*jit)->lookup("hipacc_jit_entry");
+    if (!symbol) hipaccJITError("Can't find JIT compiled kernel", symbol.takeError());
+
+    hipacc_jit_entry entry = (hipacc_jit_entry)symbol->getAddress();
+    return { std::move(*jit), entry };
+}
+
+
+// Maximum number of specializations per kernel (HIPACC_JIT_MAX_SPECIALIZATIONS,
+// default 8); further argument combinations use a generic version
+size_t hipaccJITMaxSpecializations() {
+    const char *env = getenv("HIPACC_JIT_MAX_SPECIALIZATIONS");
+    int max = env ? atoi(env) : 8;
+    return max > 0 ? max : 0;
+}
+
+
+// Generic version of a kernel: nothing is baked, all arguments are passed at
+// launch
+std::vector<hipacc_jit_arg> hipaccJITGeneric(const std::vector<hipacc_jit_arg> &args) {
+    std::vector<hipacc_jit_arg> generic(args);
+    for (auto &arg : generic) {
+        if (arg.kind != hipacc_jit_arg::Literal) continue;
+        arg.kind = arg.type.empty() ? hipacc_jit_arg::Value : hipacc_jit_arg::Pointer;
+        arg.literal.clear();
+        arg.type.clear();
+    }
+    return generic;
+}
+
+
+// Specialization for the arguments: compiled at most once per process, the
+// machine code is reused across runs from the cache directory
+hipacc_jit_entry hipaccJITCompile(const char *file_name, const char *kernel_name, const std::vector<hipacc_jit_arg> &specialized_args) {
+    static std::mutex mutex;
+    static std::map<std::string, hipacc_jit_kernel> kernels;
+    static std::map<std::string, size_t> num_specializations;
+    static std::map<std::string, std::string> kernel_files, kernel_sources;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string kernel_key = std::string(file_name) + ":" + kernel_name;
+    std::string key = kernel_key;
+    for (auto &arg : specialized_args) key += ":" + arg.literal;
+    auto kernel = kernels.find(key);
+    if (kernel != kernels.end()) return kernel->second.entry;
+
+    // arguments changing at every launch would compile a new specialization
+    // each time
+    std::vector<hipacc_jit_arg> args(specialized_args);
+    if (num_specializations[kernel_key] >= hipaccJITMaxSpecializations()) {
+        args = hipaccJITGeneric(specialized_args);
+        key = kernel_key;
+        for (auto &arg : args) key += ":" + arg.literal;
+        kernel = kernels.find(key);
+        if (kernel != kernels.end()) return kernel->second.entry;
+    } else {
+        ++num_specializations[kernel_key];
+    }
+
+    static std::once_flag init_target;
+    std::call_once(init_target, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
+
+    auto kernel_file = kernel_files.find(file_name);
+    if (kernel_file == kernel_files.end()) {
+        kernel_file = kernel_files.emplace(file_name, hipaccJITKernelFile(file_name)).first;
+    }
+    const std::string &path = kernel_file->second;
+
+    auto kernel_source = kernel_sources.find(path);
+    if (kernel_source == kernel_sources.end()) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "ERROR: Can't open kernel source file '" << path << "'!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        std::string content(std::istreambuf_iterator<char>(file),
+                            (std::istreambuf_iterator<char>()));
+        kernel_source = kernel_sources.emplace(path, content).first;
+    }
+    std::string source = hipaccJITSource(path, kernel_source->second, kernel_name, args);
+    std::vector<std::string> include_dirs;
+    std::vector<std::string> options = hipaccJITOptions(path, include_dirs);
+
+    // machine code is determined by the source and the headers it includes,
+    // the compile flags, the host CPU, and LLVM
+    std::string cpu;
+    std::vector<std::string> features;
+    hipaccJITHostCPU(cpu, features);
+    std::string cache_key = source + '\n' + cpu + '\n' + LLVM_VERSION_STRING;
+    for (auto &feature : features) cache_key += feature;
+    for (auto &option : options) cache_key += '\n' + option;
+    hipaccAppendIncludes(cache_key, source, include_dirs);
+    std::string cache_dir = hipaccJITCacheDir();
+    std::string cache_file;
+    if (!cache_dir.empty()) {
+        cache_file = cache_dir + "/" + kernel_name + "-" + hipaccTuningHash(cache_key) + ".o";
+    }
+
+    const char *verbose = getenv("HIPACC_JIT_VERBOSE");
+    bool print_progress = verbose && std::string(verbose) != "0";
+    int64_t start = hipacc_time_micro();
+
+    std::unique_ptr<llvm::MemoryBuffer> object;
+    if (!cache_file.empty()) {
+        auto buffer = llvm::MemoryBuffer::getFile(cache_file);
+        if (buffer) object = std::move(*buffer);
+    }
+    bool cached = object != nullptr;
+
+    if (!cached) {
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> module = hipaccJITParse(path, source, options, context);
+        if (!module) {
+            std::cerr << "ERROR: JIT compilation of kernel '" << kernel_name << "' failed!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        auto target = hipaccJITTargetMachineBuilder().createTargetMachine();
+        if (!target) hipaccJITError("Can't create target machine", target.takeError());
+        object = hipaccJITCodegen(*module, **target);
+        if (!object) {
+            std::cerr << "ERROR: Code generation for kernel '" << kernel_name << "' failed!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!cache_file.empty()) hipaccJITStoreObject(cache_file, *object);
+    }
+
+    kernel = kernels.emplace(key, hipaccJITLoad(std::move(object))).first;
+
+    if (print_progress) {
+        std::cerr << "<HIPACC:> JIT " << (cached ? "loaded" : "compiled")
+                  << " kernel '" << kernel_name << "' for " << cpu << ": "
+                  << (hipacc_time_micro() - start) * 1.0e-3f << " ms" << std::endl;
+    }
+
+    return kernel->second.entry;
+}
+
+
+void hipaccLaunchKernelJIT(const char *file_name, const char *kernel_name, const std::vector<hipacc_jit_arg> &args) {
+    hipacc_jit_entry entry = hipaccJITCompile(file_name, kernel_name, args);
+
+    std::vector<void *> ptrs;
+    for (auto &arg : args) ptrs.push_back(const_cast<void *>(arg.ptr));
+    entry(ptrs.data());
+}
+
+
+#endif  // __HIPACC_CPU_JIT_STANDALONE_HPP__
@@ -1,8 +1,10 @@
 #ifdef USE_OPENMP
 #  include <omp.h>
-#  define GET_NUM_CORES omp_get_num_procs()
+#  include "hipacc_base.hpp"
+#  define GET_NUM_CORES omp_get_max_threads()
 #  define GET_THREAD_ID omp_get_thread_num()
-#  define OPENMP_PRAGMA _Pragma("omp parallel for")
+// coarse pyramid levels are too small to amortize the thread team startup
+#  define OPENMP_PRAGMA _Pragma("omp parallel for if(!hipaccTraverseCoarseLevel())")
 #else
 #  define GET_NUM_CORES 1
 #  define GET_THREAD_ID 0
@@ -45,17 +47,22 @@ inline DATA_TYPE NAME ##Kernel(DATA_TYPE input[HEIGHT][WIDTH], int width, int he
        for (int m = 0; m < missing; ++m) { \
             const int tid = GET_THREAD_ID; \
             int gy = gid_y + m; \
-            for (int gid_x = offset_x; gid_x < offset_x + width; ++gid_x) { \
+            if (init[tid] == 1) part_result[tid] = input[gy][offset_x]; \
+            for (int gid_x = offset_x + init[tid]; gid_x < offset_x + width; ++gid_x) { \
                 part_result[tid] = REDUCE(part_result[tid], input[gy][gid_x]); \
             } \
+            init[tid] = 0; \
        } \
     } \
  \
-    for (int i = 1; i < num_cores; ++i) { \
-        part_result[0] = REDUCE(part_result[0], part_result[i]); \
+    /* threads without rows, e.g. all but the first on coarse levels, */ \
+    /* have no partial result */ \
+    int first = 0; \
+    while (first < num_cores - 1 && init[first] == 1) ++first; \
+    DATA_TYPE result = part_result[first]; \
+    for (int i = first + 1; i < num_cores; ++i) { \
+        if (init[i] == 0) result = REDUCE(result, part_result[i]); \
     } \
- \
-    DATA_TYPE result = part_result[0]; \
  \
     delete [] init; \
     delete [] part_result; \
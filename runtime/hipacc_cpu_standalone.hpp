@@ -36,6 +36,17 @@
 
 #include "hipacc_base_standalone.hpp"
 
+#if defined(__linux__) && !defined(HIPACC_NO_METRICS)
+# define HIPACC_PERF_EVENTS
+# include <algorithm>
+# include <cstdlib>
+# include <linux/perf_event.h>
+# include <mutex>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
 
 HipaccContext& HipaccContext::getInstance() {
     static HipaccContext instance;
@@ -45,33 +56,181 @@ HipaccContext& HipaccContext::getInstance() {
 
 HipaccImageCPU::HipaccImageCPU(size_t width, size_t height, size_t stride,
                size_t alignment, size_t pixel_size, void* mem,
-               hipaccMemoryType mem_type)
+               hipaccMemoryType mem_type, std::shared_ptr<char> arena)
     : HipaccImageBase(width, height, stride, alignment, pixel_size, mem,
-        mem_type), mem((char*)mem) {
+        mem_type), mem((char*)mem), arena(arena) {
 }
 
 HipaccImageCPU::~HipaccImageCPU() {
-    delete[] mem;
+    // memory within an arena is released together with the last image using it
+    if (!arena)
+        delete[] mem;
 }
 
 int64_t start_time = 0;
 int64_t end_time = 0;
 
+
+#ifdef HIPACC_PERF_EVENTS
+// Hardware performance counters via perf_event_open, enabled by setting
+// HIPACC_PERF_COUNTERS=1. Counters count the thread that opened them, so each
+// thread executing kernels has its own; a kernel is measured on all threads of
+// the OpenMP team, including the time workers wait in the OpenMP runtime.
+// Counters that cannot be opened (missing permissions, virtualized PMU, ...)
+// are reported as unavailable.
+class HipaccPerfEvents {
+    private:
+        int fds[PerfNumCounters];
+        bool opened;
+
+        HipaccPerfEvents() : opened(false) {
+            std::fill(fds, fds + PerfNumCounters, -1);
+
+            const uint64_t configs[PerfNumCounters] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES
+            };
+
+            for (int i=0; i<PerfNumCounters; ++i) {
+                struct perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[i];
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+                opened |= fds[i] >= 0;
+            }
+        }
+
+        ~HipaccPerfEvents() {
+            for (int i=0; i<PerfNumCounters; ++i) {
+                if (fds[i] >= 0)
+                    close(fds[i]);
+            }
+        }
+
+        // counters of the calling thread
+        static HipaccPerfEvents &getThreadInstance() {
+            thread_local HipaccPerfEvents instance;
+            return instance;
+        }
+
+        void enable() {
+            for (int i=0; i<PerfNumCounters; ++i) {
+                if (fds[i] >= 0) {
+                    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        void disable(int64_t *values) {
+            for (int i=0; i<PerfNumCounters; ++i) {
+                uint64_t count = 0;
+                values[i] = -1;
+                if (fds[i] >= 0) {
+                    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+                    if (read(fds[i], &count, sizeof(count)) == sizeof(count))
+                        values[i] = count;
+                }
+            }
+        }
+
+    public:
+        static bool is_enabled() {
+            static const bool enabled = [] {
+                const char *env = std::getenv("HIPACC_PERF_COUNTERS");
+                if (!env || std::atoi(env) == 0)
+                    return false;
+                if (!getThreadInstance().opened) {
+                    std::cerr << "<HIPACC:> Hardware performance counters are not available"
+                              << std::endl;
+                    return false;
+                }
+                return true;
+            }();
+            return enabled;
+        }
+
+        static void start() {
+            #ifdef _OPENMP
+            #pragma omp parallel
+            #endif
+            getThreadInstance().enable();
+        }
+
+        // sum of the counters of all threads, -1 if unavailable
+        static void stop(int64_t *values) {
+            std::fill(values, values + PerfNumCounters, -1);
+            std::mutex mutex;
+
+            #ifdef _OPENMP
+            #pragma omp parallel
+            #endif
+            {
+                int64_t thread_values[PerfNumCounters];
+                getThreadInstance().disable(thread_values);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                for (int i=0; i<PerfNumCounters; ++i) {
+                    if (thread_values[i] >= 0)
+                        values[i] = std::max<int64_t>(values[i], 0) + thread_values[i];
+                }
+            }
+        }
+};
+#endif
+
+
 void hipaccStartTiming() {
+    #ifdef HIPACC_PERF_EVENTS
+    if (HipaccPerfEvents::is_enabled())
+        HipaccPerfEvents::start();
+    #endif
     start_time = hipacc_time_micro();
 }
 
-void hipaccStopTiming() {
+void hipaccStopTiming(const char *kernel_name, size_t width, size_t height,
+                      unsigned ops_per_pixel, unsigned bytes_per_pixel) {
     end_time = hipacc_time_micro();
     hipacc_last_timing = (end_time - start_time) * 1.0e-3f;
 
-    std::cerr << "<HIPACC:> Kernel timing: "
-              << hipacc_last_timing << "(ms)" << std::endl;
+    #ifndef HIPACC_NO_METRICS
+    int64_t *counters = nullptr;
+    #ifdef HIPACC_PERF_EVENTS
+    int64_t values[PerfNumCounters];
+    if (HipaccPerfEvents::is_enabled()) {
+        HipaccPerfEvents::stop(values);
+        counters = values;
+    }
+    #endif
+
+    if (kernel_name)
+        hipaccMetricsRecord(kernel_name, hipacc_last_timing, width*height,
+                            counters, ops_per_pixel, bytes_per_pixel);
+
+    if (hipaccMetricsPrintTiming()) {
+        std::cerr << "<HIPACC:> Kernel timing";
+        if (kernel_name)
+            std::cerr << " (" << kernel_name << ")";
+        std::cerr << ": " << hipacc_last_timing << "(ms)" << std::endl;
+    }
+    #endif
+
+    hipaccTraceEvent(kernel_name ? kernel_name : "kernel", "kernel", start_time,
+                     end_time, width, height, hipaccTraverseLevel());
 }
 
 
 // Copy from memory to memory
 void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst) {
+    HipaccTraceScope trace("hipaccCopyMemory", "copy", src->width, src->height);
     size_t height = src->height;
     size_t stride = src->stride;
     std::memcpy(dst->mem, src->mem, src->pixel_size*stride*height);
@@ -80,6 +239,7 @@ void hipaccCopyMemory(const HipaccImage &src, HipaccImage &dst) {
 
 // Copy from memory region to memory region
 void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst) {
+    HipaccTraceScope trace("hipaccCopyMemoryRegion", "copy", dst.width, dst.height);
     for (size_t i=0; i<dst.height; ++i) {
         std::memcpy(&((uchar*)dst.img->mem)[dst.offset_x*dst.img->pixel_size + (dst.offset_y + i)*dst.img->stride*dst.img->pixel_size],
                     &((uchar*)src.img->mem)[src.offset_x*src.img->pixel_size + (src.offset_y + i)*src.img->stride*src.img->pixel_size],
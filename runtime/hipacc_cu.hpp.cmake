@@ -205,6 +205,8 @@ HipaccImage hipaccCreateArray2D(T *host_mem, size_t width, size_t height);
 template<typename T>
 HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height);
 template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth);
+template<typename T>
 void hipaccWriteMemory(HipaccImage &img, T *host_mem);
 template<typename T>
 T *hipaccReadMemory(const HipaccImage &img);
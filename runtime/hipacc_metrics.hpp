@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_METRICS_HPP__
+#define __HIPACC_METRICS_HPP__
+
+// Runtime metrics registry: collects per-kernel statistics for every timed
+// kernel launch. Define HIPACC_NO_METRICS to compile the registry out.
+//
+// Kernels translated by hipacc pass the operations and bytes per pixel
+// estimated at compile time, so that achieved GOP/s and GB/s can be put in
+// relation to the machine roofline. The roofline is read from the file given
+// by HIPACC_ROOFLINE (as written by cpu_bandwidth_test).
+
+#ifndef HIPACC_NO_METRICS
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+// number of most recent timings kept per kernel for percentile queries
+#ifndef HIPACC_METRICS_SAMPLES
+# define HIPACC_METRICS_SAMPLES 1024
+#endif
+
+// hardware performance counters sampled around kernel launches
+enum hipaccPerfCounter {
+    PerfCycles,
+    PerfInstructions,
+    PerfLLCMisses,
+    PerfBranchMisses,
+    PerfNumCounters
+};
+
+class HipaccKernelMetrics {
+    public:
+        std::string name;
+        size_t calls;
+        double total_time, min_time, max_time;  // in ms
+        uint64_t pixels;
+        std::vector<float> samples;
+        size_t next_sample;
+        // accumulated counter values, -1 if a counter is not available
+        int64_t counters[PerfNumCounters];
+        // compile-time estimate of the work per pixel, 0 if unknown
+        unsigned ops_per_pixel, bytes_per_pixel;
+
+    public:
+        HipaccKernelMetrics(const std::string &name);
+        void add(float time, size_t num_pixels, const int64_t *values,
+                 unsigned ops=0, unsigned bytes=0);
+        double avg_time() const;
+        float percentile(float p) const;
+        double mpixels_per_second() const;
+        double intensity() const;
+        double gops_per_second() const;
+        double gbytes_per_second() const;
+};
+
+
+const char *hipaccPerfCounterName(hipaccPerfCounter counter);
+void hipaccMetricsRecord(const std::string &name, float time, size_t pixels=0,
+                         const int64_t *counters=nullptr,
+                         unsigned ops_per_pixel=0, unsigned bytes_per_pixel=0);
+bool hipaccMetricsGet(const std::string &name, HipaccKernelMetrics &metrics);
+std::map<std::string, HipaccKernelMetrics> hipaccMetricsAll();
+void hipaccMetricsReset();
+void hipaccMetricsSetPrintTiming(bool print);
+bool hipaccMetricsPrintTiming();
+void hipaccMetricsWriteJSON(std::ostream &os);
+void hipaccMetricsWriteCSV(std::ostream &os);
+bool hipaccMetricsExport(const std::string &file_name);
+void hipaccMetricsSetRoofline(double peak_gops, double peak_gb_s);
+bool hipaccMetricsLoadRoofline(const std::string &file_name);
+void hipaccMetricsWriteRoofline(std::ostream &os);
+
+#endif // HIPACC_NO_METRICS
+
+#endif // __HIPACC_METRICS_HPP__
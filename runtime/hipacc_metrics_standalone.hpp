@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+// This is the standalone (header-only) Hipacc metrics registry
+
+
+#include "hipacc_metrics.hpp"
+
+
+#ifndef __HIPACC_METRICS_STANDALONE_HPP__
+#define __HIPACC_METRICS_STANDALONE_HPP__
+
+#ifndef HIPACC_NO_METRICS
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+
+HipaccKernelMetrics::HipaccKernelMetrics(const std::string &name)
+    : name(name), calls(0), total_time(0),
+      min_time(std::numeric_limits<double>::max()), max_time(0), pixels(0),
+      next_sample(0), ops_per_pixel(0), bytes_per_pixel(0) {
+    std::fill(counters, counters + PerfNumCounters, -1);
+}
+
+void HipaccKernelMetrics::add(float time, size_t num_pixels, const int64_t *values,
+                              unsigned ops, unsigned bytes) {
+    ++calls;
+    if (ops) ops_per_pixel = ops;
+    if (bytes) bytes_per_pixel = bytes;
+    total_time += time;
+    min_time = std::min(min_time, (double)time);
+    max_time = std::max(max_time, (double)time);
+    pixels += num_pixels;
+
+    // a counter is reported only if it was available for every launch
+    for (int i=0; i<PerfNumCounters; ++i) {
+        if (!values || values[i] < 0)
+            counters[i] = -1;
+        else if (calls == 1)
+            counters[i] = values[i];
+        else if (counters[i] >= 0)
+            counters[i] += values[i];
+    }
+
+    // keep a ring buffer of the most recent timings
+    if (samples.size() < HIPACC_METRICS_SAMPLES) {
+        samples.push_back(time);
+    } else {
+        samples[next_sample] = time;
+        next_sample = (next_sample + 1) % HIPACC_METRICS_SAMPLES;
+    }
+}
+
+double HipaccKernelMetrics::avg_time() const {
+    return calls ? total_time / calls : 0.0;
+}
+
+float HipaccKernelMetrics::percentile(float p) const {
+    if (samples.empty())
+        return 0.0f;
+
+    std::vector<float> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    size_t idx = (size_t)(std::min(std::max(p, 0.0f), 100.0f) / 100.0f *
+                          (sorted.size() - 1) + 0.5f);
+    return sorted[idx];
+}
+
+double HipaccKernelMetrics::mpixels_per_second() const {
+    return total_time > 0 ? pixels / (total_time * 1.0e3) : 0.0;
+}
+
+double HipaccKernelMetrics::intensity() const {
+    return bytes_per_pixel ? (double)ops_per_pixel / bytes_per_pixel : 0.0;
+}
+
+double HipaccKernelMetrics::gops_per_second() const {
+    return mpixels_per_second() * ops_per_pixel * 1.0e-3;
+}
+
+double HipaccKernelMetrics::gbytes_per_second() const {
+    return mpixels_per_second() * bytes_per_pixel * 1.0e-3;
+}
+
+
+const char *hipaccPerfCounterName(hipaccPerfCounter counter) {
+    switch (counter) {
+        case PerfCycles:       return "cycles";
+        case PerfInstructions: return "instructions";
+        case PerfLLCMisses:    return "llc_misses";
+        case PerfBranchMisses: return "branch_misses";
+        default:               return "unknown";
+    }
+}
+
+
+class HipaccMetricsRegistry {
+    public:
+        std::mutex mutex;
+        std::map<std::string, HipaccKernelMetrics> kernels;
+        bool print_timing;
+        // machine roofline, 0 if unknown
+        double peak_gops, peak_gb_s;
+
+        static HipaccMetricsRegistry &getInstance() {
+            static HipaccMetricsRegistry instance;
+            return instance;
+        }
+
+        void writeJSON(std::ostream &os) {
+            os << "{\n  \"kernels\": [";
+            bool first = true;
+            for (auto &entry : kernels) {
+                const HipaccKernelMetrics &M = entry.second;
+                os << (first ? "\n" : ",\n");
+                os << "    {\"name\": \"" << M.name << "\""
+                   << ", \"calls\": " << M.calls
+                   << ", \"total_ms\": " << M.total_time
+                   << ", \"min_ms\": " << M.min_time
+                   << ", \"max_ms\": " << M.max_time
+                   << ", \"avg_ms\": " << M.avg_time()
+                   << ", \"p50_ms\": " << M.percentile(50)
+                   << ", \"p90_ms\": " << M.percentile(90)
+                   << ", \"p99_ms\": " << M.percentile(99)
+                   << ", \"pixels\": " << M.pixels
+                   << ", \"mpixels_per_s\": " << M.mpixels_per_second();
+                for (int i=0; i<PerfNumCounters; ++i) {
+                    if (M.counters[i] >= 0)
+                        os << ", \"" << hipaccPerfCounterName((hipaccPerfCounter)i)
+                           << "\": " << M.counters[i];
+                }
+                if (M.counters[PerfCycles] > 0 && M.counters[PerfInstructions] >= 0)
+                    os << ", \"ipc\": " << (double)M.counters[PerfInstructions] /
+                                            M.counters[PerfCycles];
+                if (M.bytes_per_pixel) {
+                    os << ", \"ops_per_pixel\": " << M.ops_per_pixel
+                       << ", \"bytes_per_pixel\": " << M.bytes_per_pixel
+                       << ", \"intensity\": " << M.intensity()
+                       << ", \"gops_per_s\": " << M.gops_per_second()
+                       << ", \"gb_per_s\": " << M.gbytes_per_second();
+                    if (double attainable = attainableGops(M))
+                        os << ", \"attainable_gops_per_s\": " << attainable
+                           << ", \"roofline_efficiency\": " << M.gops_per_second() / attainable;
+                }
+                os << "}";
+                first = false;
+            }
+            os << "\n  ]\n}\n";
+        }
+
+        void writeCSV(std::ostream &os) {
+            os << "name,calls,total_ms,min_ms,max_ms,avg_ms,p50_ms,p90_ms,"
+                  "p99_ms,pixels,mpixels_per_s";
+            for (int i=0; i<PerfNumCounters; ++i)
+                os << "," << hipaccPerfCounterName((hipaccPerfCounter)i);
+            os << ",ops_per_pixel,bytes_per_pixel,intensity,gops_per_s,"
+                  "gb_per_s,attainable_gops_per_s\n";
+            for (auto &entry : kernels) {
+                const HipaccKernelMetrics &M = entry.second;
+                os << M.name << "," << M.calls << "," << M.total_time << ","
+                   << M.min_time << "," << M.max_time << "," << M.avg_time()
+                   << "," << M.percentile(50) << "," << M.percentile(90)
+                   << "," << M.percentile(99) << "," << M.pixels << ","
+                   << M.mpixels_per_second();
+                // leave unavailable counters empty
+                for (int i=0; i<PerfNumCounters; ++i) {
+                    os << ",";
+                    if (M.counters[i] >= 0)
+                        os << M.counters[i];
+                }
+                os << ",";
+                if (M.bytes_per_pixel)
+                    os << M.ops_per_pixel << "," << M.bytes_per_pixel << ","
+                       << M.intensity() << "," << M.gops_per_second() << ","
+                       << M.gbytes_per_second() << "," << attainableGops(M);
+                else
+                    os << ",,,,,";
+                os << "\n";
+            }
+        }
+
+        // attainable performance of a kernel according to the roofline
+        double attainableGops(const HipaccKernelMetrics &M) {
+            if (!peak_gb_s || !M.bytes_per_pixel)
+                return 0.0;
+            double memory_bound = M.intensity() * peak_gb_s;
+            return peak_gops ? std::min(peak_gops, memory_bound) : memory_bound;
+        }
+
+        // read "peak_gops" and "peak_bandwidth_gb_s" from a JSON file
+        bool loadRoofline(const std::string &file_name) {
+            std::ifstream file(file_name);
+            if (!file.is_open()) {
+                std::cerr << "<HIPACC:> Could not open roofline file '"
+                          << file_name << "'" << std::endl;
+                return false;
+            }
+            std::stringstream content;
+            content << file.rdbuf();
+            std::string str = content.str();
+
+            auto read_value = [&] (const std::string &key) -> double {
+                size_t pos = str.find("\"" + key + "\"");
+                if (pos == std::string::npos) return 0.0;
+                pos = str.find(':', pos);
+                return pos == std::string::npos ? 0.0 : std::atof(str.c_str() + pos + 1);
+            };
+            peak_gops = read_value("peak_gops");
+            peak_gb_s = read_value("peak_bandwidth_gb_s");
+            return peak_gb_s > 0;
+        }
+
+        void writeRoofline(std::ostream &os) {
+            os << "<HIPACC:> Roofline (peak " << peak_gops << " GOP/s, "
+               << peak_gb_s << " GB/s):" << std::endl;
+            for (auto &entry : kernels) {
+                const HipaccKernelMetrics &M = entry.second;
+                if (!M.bytes_per_pixel) continue;
+                double attainable = attainableGops(M);
+                bool memory_bound = !peak_gops || M.intensity() * peak_gb_s < peak_gops;
+                os << "<HIPACC:>   " << M.name << ": " << M.intensity()
+                   << " ops/byte, " << M.gops_per_second() << " GOP/s, "
+                   << M.gbytes_per_second() << " GB/s";
+                if (attainable)
+                    os << ", " << 100.0 * M.gops_per_second() / attainable
+                       << "% of " << (memory_bound ? "memory" : "compute")
+                       << " bound " << attainable << " GOP/s";
+                os << std::endl;
+            }
+        }
+
+        // write metrics to file, the format is chosen by the file extension
+        bool writeFile(const std::string &file_name) {
+            std::ofstream file(file_name);
+            if (!file.is_open()) {
+                std::cerr << "<HIPACC:> Could not open metrics file '"
+                          << file_name << "'" << std::endl;
+                return false;
+            }
+
+            size_t pos = file_name.rfind('.');
+            if (pos != std::string::npos && file_name.substr(pos) == ".csv") {
+                writeCSV(file);
+            } else {
+                writeJSON(file);
+            }
+            return true;
+        }
+
+    private:
+        HipaccMetricsRegistry() : print_timing(false), peak_gops(0), peak_gb_s(0) {
+            if (const char *env = std::getenv("HIPACC_PRINT_TIMING"))
+                print_timing = std::atoi(env) != 0;
+            if (const char *env = std::getenv("HIPACC_ROOFLINE"))
+                loadRoofline(env);
+        }
+
+        ~HipaccMetricsRegistry() {
+            // dump metrics on exit if requested
+            if (const char *env = std::getenv("HIPACC_METRICS"))
+                writeFile(env);
+            if (peak_gb_s > 0)
+                writeRoofline(std::cerr);
+        }
+};
+
+
+void hipaccMetricsRecord(const std::string &name, float time, size_t pixels,
+                         const int64_t *counters, unsigned ops_per_pixel,
+                         unsigned bytes_per_pixel) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+
+    auto it = Reg.kernels.find(name);
+    if (it == Reg.kernels.end())
+        it = Reg.kernels.emplace(name, HipaccKernelMetrics(name)).first;
+    it->second.add(time, pixels, counters, ops_per_pixel, bytes_per_pixel);
+}
+
+// copies of the metrics, other threads may record while the caller reads
+bool hipaccMetricsGet(const std::string &name, HipaccKernelMetrics &metrics) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+
+    auto it = Reg.kernels.find(name);
+    if (it == Reg.kernels.end())
+        return false;
+    metrics = it->second;
+    return true;
+}
+
+std::map<std::string, HipaccKernelMetrics> hipaccMetricsAll() {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    return Reg.kernels;
+}
+
+void hipaccMetricsReset() {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    Reg.kernels.clear();
+}
+
+void hipaccMetricsSetPrintTiming(bool print) {
+    HipaccMetricsRegistry::getInstance().print_timing = print;
+}
+
+bool hipaccMetricsPrintTiming() {
+    return HipaccMetricsRegistry::getInstance().print_timing;
+}
+
+void hipaccMetricsWriteJSON(std::ostream &os) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    Reg.writeJSON(os);
+}
+
+void hipaccMetricsWriteCSV(std::ostream &os) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    Reg.writeCSV(os);
+}
+
+bool hipaccMetricsExport(const std::string &file_name) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    return Reg.writeFile(file_name);
+}
+
+void hipaccMetricsSetRoofline(double peak_gops, double peak_gb_s) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    Reg.peak_gops = peak_gops;
+    Reg.peak_gb_s = peak_gb_s;
+}
+
+bool hipaccMetricsLoadRoofline(const std::string &file_name) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    return Reg.loadRoofline(file_name);
+}
+
+void hipaccMetricsWriteRoofline(std::ostream &os) {
+    HipaccMetricsRegistry &Reg = HipaccMetricsRegistry::getInstance();
+    std::lock_guard<std::mutex> lock(Reg.mutex);
+    Reg.writeRoofline(os);
+}
+
+#endif // HIPACC_NO_METRICS
+
+#endif // __HIPACC_METRICS_STANDALONE_HPP__
@@ -205,6 +205,8 @@ T hipaccApplyReduction(
     int is_width, bool print_timing=true);
 template<typename T>
 HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size_t height);
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth);
 
 
 #include "hipacc_rs.tpp"
@@ -377,4 +377,10 @@ HipaccImage hipaccCreatePyramidImage(const HipaccImage &base, size_t width, size
 }
 
 
+template<typename T>
+std::vector<HipaccImage> hipaccCreatePyramidImages(const HipaccImage &base, size_t depth) {
+    return hipaccAllocPyramidLevels<T>(base, depth);
+}
+
+
 #endif  // __HIPACC_RS_TPP__
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_TRACE_HPP__
+#define __HIPACC_TRACE_HPP__
+
+// Event tracing of runtime activity (kernel launches, memory copies, pyramid
+// traversal). Tracing is enabled at run time by setting HIPACC_TRACE=<file>;
+// events are written in Trace Event JSON format (chrome://tracing, Perfetto)
+// at program exit. Define HIPACC_NO_TRACE to compile tracing out. Event names
+// and categories are not copied: they have to be string literals or outlive
+// the trace.
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef HIPACC_NO_TRACE
+
+bool hipaccTraceEnabled();
+void hipaccTraceEvent(const char *name, const char *category, int64_t start,
+                      int64_t end, size_t width=0, size_t height=0,
+                      int level=-1);
+bool hipaccTraceWrite(const char *file_name);
+
+#else
+
+inline bool hipaccTraceEnabled() { return false; }
+inline void hipaccTraceEvent(const char *, const char *, int64_t, int64_t,
+                             size_t=0, size_t=0, int=-1) {}
+inline bool hipaccTraceWrite(const char *) { return false; }
+
+#endif // HIPACC_NO_TRACE
+
+
+// Records the lifetime of the scope as one event
+class HipaccTraceScope {
+    private:
+        const char *name, *category;
+        size_t width, height;
+        int level;
+        int64_t start;
+
+    public:
+        HipaccTraceScope(const char *name, const char *category,
+                         size_t width=0, size_t height=0, int level=-1);
+        ~HipaccTraceScope();
+};
+
+#endif // __HIPACC_TRACE_HPP__
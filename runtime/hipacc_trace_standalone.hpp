@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+// This is the standalone (header-only) Hipacc event tracing
+
+
+#include "hipacc_trace.hpp"
+
+
+#ifndef __HIPACC_TRACE_STANDALONE_HPP__
+#define __HIPACC_TRACE_STANDALONE_HPP__
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+#ifndef HIPACC_NO_TRACE
+
+#ifndef HIPACC_TRACE_CHUNK_EVENTS
+# define HIPACC_TRACE_CHUNK_EVENTS 1024
+#endif
+
+struct hipacc_trace_event {
+    const char *name;
+    const char *category;
+    int64_t start, end;
+    size_t width, height;
+    int level;
+};
+
+// events are stored in a list of fixed-size chunks, so that recorded events
+// never move
+struct hipacc_trace_chunk {
+    hipacc_trace_event events[HIPACC_TRACE_CHUNK_EVENTS];
+    std::atomic<hipacc_trace_chunk *> next;
+
+    hipacc_trace_chunk() : next(nullptr) {}
+};
+
+// Events of one thread: only the owning thread appends to the buffer, without
+// locking. An event is published by incrementing the count after it has been
+// written, so the trace can be written while other threads still record
+// events; it contains the events published up to then.
+struct hipacc_trace_buffer {
+    int tid;
+    std::atomic<size_t> count;
+    hipacc_trace_chunk first;
+    hipacc_trace_chunk *last;
+
+    hipacc_trace_buffer() : tid(0), count(0), last(&first) {}
+
+    ~hipacc_trace_buffer() {
+        hipacc_trace_chunk *chunk = first.next.load();
+        while (chunk) {
+            hipacc_trace_chunk *next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    // called by the owning thread only
+    void append(const hipacc_trace_event &event) {
+        size_t n = count.load(std::memory_order_relaxed);
+        size_t index = n % HIPACC_TRACE_CHUNK_EVENTS;
+        if (n && !index) {
+            hipacc_trace_chunk *chunk = new hipacc_trace_chunk();
+            last->next.store(chunk, std::memory_order_release);
+            last = chunk;
+        }
+        last->events[index] = event;
+        count.store(n + 1, std::memory_order_release);
+    }
+};
+
+
+class HipaccTraceRegistry {
+    public:
+        std::mutex mutex;
+        std::vector<std::unique_ptr<hipacc_trace_buffer>> buffers;
+        const char *file_name;
+
+        static HipaccTraceRegistry &getInstance() {
+            static HipaccTraceRegistry instance;
+            return instance;
+        }
+
+        // called once per thread on its first event
+        hipacc_trace_buffer *createBuffer() {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.emplace_back(new hipacc_trace_buffer());
+            buffers.back()->tid = (int)buffers.size();
+            return buffers.back().get();
+        }
+
+        bool write(const char *name) {
+            std::ofstream file(name);
+            if (!file.is_open()) {
+                std::cerr << "<HIPACC:> Could not open trace file '" << name
+                          << "'" << std::endl;
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            file << "{\"traceEvents\": [";
+            bool first = true;
+            for (auto &buffer : buffers) {
+                size_t count = buffer->count.load(std::memory_order_acquire);
+                const hipacc_trace_chunk *chunk = &buffer->first;
+                for (size_t i=0; i<count; ++i) {
+                    if (i && !(i % HIPACC_TRACE_CHUNK_EVENTS))
+                        chunk = chunk->next.load(std::memory_order_acquire);
+                    const hipacc_trace_event &event =
+                        chunk->events[i % HIPACC_TRACE_CHUNK_EVENTS];
+                    file << (first ? "\n" : ",\n");
+                    file << "  {\"name\": \"" << event.name << "\""
+                         << ", \"cat\": \"" << event.category << "\""
+                         << ", \"ph\": \"X\", \"pid\": 0"
+                         << ", \"tid\": " << buffer->tid
+                         << ", \"ts\": " << event.start
+                         << ", \"dur\": " << event.end - event.start
+                         << ", \"args\": {";
+                    if (event.width || event.height)
+                        file << "\"width\": " << event.width
+                             << ", \"height\": " << event.height;
+                    if (event.level >= 0)
+                        file << (event.width || event.height ? ", " : "")
+                             << "\"level\": " << event.level;
+                    file << "}}";
+                    first = false;
+                }
+            }
+            file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+            return true;
+        }
+
+    private:
+        HipaccTraceRegistry() : file_name(std::getenv("HIPACC_TRACE")) {}
+
+        ~HipaccTraceRegistry() {
+            if (file_name)
+                write(file_name);
+        }
+};
+
+
+bool hipaccTraceEnabled() {
+    static const bool enabled = HipaccTraceRegistry::getInstance().file_name != nullptr;
+    return enabled;
+}
+
+void hipaccTraceEvent(const char *name, const char *category, int64_t start,
+                      int64_t end, size_t width, size_t height, int level) {
+    if (!hipaccTraceEnabled())
+        return;
+
+    thread_local hipacc_trace_buffer *buffer =
+        HipaccTraceRegistry::getInstance().createBuffer();
+    hipacc_trace_event event = { name, category, start, end, width, height, level };
+    buffer->append(event);
+}
+
+bool hipaccTraceWrite(const char *file_name) {
+    return HipaccTraceRegistry::getInstance().write(file_name);
+}
+
+#endif // HIPACC_NO_TRACE
+
+
+HipaccTraceScope::HipaccTraceScope(const char *name, const char *category,
+                                   size_t width, size_t height, int level)
+    : name(name), category(category), width(width), height(height),
+      level(level), start(hipaccTraceEnabled() ? hipacc_time_micro() : 0) {}
+
+HipaccTraceScope::~HipaccTraceScope() {
+    if (hipaccTraceEnabled())
+        hipaccTraceEvent(name, category, start, hipacc_time_micro(), width,
+                         height, level);
+}
+
+#endif // __HIPACC_TRACE_STANDALONE_HPP__
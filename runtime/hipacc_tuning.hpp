@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_TUNING_HPP__
+#define __HIPACC_TUNING_HPP__
+
+// Persistent database of tuned kernel configurations. Explored kernels store
+// the best configuration found under a key identifying the kernel source, the
+// problem size and the machine; later runs look the key up and skip the
+// exploration. The database is the file given by HIPACC_TUNING_DB, by default
+// hipacc_tuning.db in the working directory.
+//
+// A key consists of a scope (e.g. kernel, image size and device) and a
+// version (e.g. hash of the kernel source and driver version). There is one
+// entry per scope: a lookup with another version misses, so changed kernels
+// and drivers are explored again and their configuration replaces the
+// outdated one. Setting HIPACC_TUNING_REEXPLORE=1 ignores all stored entries.
+
+#include <string>
+#include <vector>
+
+// model name of the host CPU, used in tuning keys
+std::string hipaccTuningCPUModel();
+// hash of kernel source code or other data, used in tuning keys
+std::string hipaccTuningHash(const std::string &data);
+// appends the contents of the files included by source, searched in the
+// include directories, to the key of a cached binary; headers that can't be
+// found add their name only
+void hipaccAppendIncludes(std::string &key, const std::string &source,
+                          const std::vector<std::string> &include_dirs);
+// creates an empty file (mode 0644) with a unique name starting with prefix
+// and returns its name, or an empty string on failure; files written under
+// this name are renamed to replace their target atomically
+std::string hipaccTempFile(const std::string &prefix);
+// returns true and the stored configuration if scope and version match
+bool hipaccTuningLookup(const std::string &scope, const std::string &version,
+                        std::vector<int> &config);
+// adds or replaces the configuration for the scope and writes the database
+void hipaccTuningStore(const std::string &scope, const std::string &version,
+                       const std::vector<int> &config, float time);
+
+#endif // __HIPACC_TUNING_HPP__
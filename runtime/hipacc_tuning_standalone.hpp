@@ -0,0 +1,333 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+// This is the standalone (header-only) Hipacc tuning database
+
+
+#include "hipacc_tuning.hpp"
+
+
+#ifndef __HIPACC_TUNING_STANDALONE_HPP__
+#define __HIPACC_TUNING_STANDALONE_HPP__
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#ifdef _WIN32
+#include <atomic>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+struct hipacc_tuning_entry {
+    std::string version;
+    std::vector<int> config;
+    float time;
+};
+
+
+class HipaccTuningDatabase {
+    private:
+        typedef std::map<std::string, hipacc_tuning_entry> EntryMap;
+
+        std::mutex mutex;
+        std::string file_name;
+        EntryMap entries;
+        bool loaded, reexplore;
+
+        HipaccTuningDatabase() : loaded(false), reexplore(false) {
+            const char *env = std::getenv("HIPACC_TUNING_DB");
+            file_name = env ? env : "hipacc_tuning.db";
+            if (const char *env = std::getenv("HIPACC_TUNING_REEXPLORE"))
+                reexplore = std::atoi(env) != 0;
+        }
+
+        // fields are stored without whitespace, e.g. from device names
+        static std::string normalize(const std::string &field) {
+            std::string str(field.empty() ? "-" : field);
+            for (auto &c : str)
+                if (std::isspace((unsigned char)c)) c = '_';
+            return str;
+        }
+
+        // one entry per line: <scope> <version> <time> <config values ...>
+        void read(EntryMap &map) {
+            std::ifstream file(file_name);
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.empty() || line[0] == '#')
+                    continue;
+                std::istringstream ss(line);
+                std::string scope;
+                hipacc_tuning_entry entry;
+                if (!(ss >> scope >> entry.version >> entry.time))
+                    continue;
+                int value;
+                while (ss >> value)
+                    entry.config.push_back(value);
+                map[scope] = entry;
+            }
+        }
+
+        void load() {
+            if (loaded) return;
+            read(entries);
+            loaded = true;
+        }
+
+        // advisory lock of the database shared by all processes, held while
+        // the file is read, merged and replaced; returns -1 if unavailable
+        int lock() {
+            std::string lock_name = file_name + ".lock";
+            #ifdef _WIN32
+            int fd = _open(lock_name.c_str(), _O_CREAT | _O_RDWR, _S_IREAD | _S_IWRITE);
+            if (fd >= 0 && _locking(fd, _LK_LOCK, 1) != 0) {
+                _close(fd);
+                fd = -1;
+            }
+            #else
+            int fd = open(lock_name.c_str(), O_CREAT | O_RDWR, 0644);
+            if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+                close(fd);
+                fd = -1;
+            }
+            #endif
+            return fd;
+        }
+
+        void unlock(int fd) {
+            if (fd < 0)
+                return;
+            #ifdef _WIN32
+            _lseek(fd, 0, SEEK_SET);
+            _locking(fd, _LK_UNLCK, 1);
+            _close(fd);
+            #else
+            close(fd);
+            #endif
+        }
+
+        // merge with entries written by other processes meanwhile and
+        // replace the file atomically
+        void write() {
+            int fd = lock();
+            if (fd < 0)
+                std::cerr << "<HIPACC:> Could not lock tuning database '"
+                          << file_name << "'" << std::endl;
+
+            EntryMap merged;
+            read(merged);
+            for (auto &entry : entries)
+                merged[entry.first] = entry.second;
+
+            std::string tmp_name = hipaccTempFile(file_name);
+            {
+                std::ofstream file(tmp_name);
+                if (tmp_name.empty() || !file.is_open()) {
+                    std::cerr << "<HIPACC:> Could not write tuning database '"
+                              << file_name << "'" << std::endl;
+                    if (!tmp_name.empty())
+                        std::remove(tmp_name.c_str());
+                    unlock(fd);
+                    return;
+                }
+                file << "# Hipacc tuning database: <scope> <version> <time ms> <configuration>\n";
+                for (auto &entry : merged) {
+                    file << entry.first << " " << entry.second.version << " "
+                         << entry.second.time;
+                    for (auto value : entry.second.config)
+                        file << " " << value;
+                    file << "\n";
+                }
+            }
+            if (std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+                std::cerr << "<HIPACC:> Could not write tuning database '"
+                          << file_name << "'" << std::endl;
+                std::remove(tmp_name.c_str());
+            }
+            unlock(fd);
+        }
+
+    public:
+        static HipaccTuningDatabase &getInstance() {
+            static HipaccTuningDatabase instance;
+            return instance;
+        }
+
+        bool lookup(const std::string &scope, const std::string &version,
+                    std::vector<int> &config) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (reexplore)
+                return false;
+            load();
+            auto it = entries.find(normalize(scope));
+            if (it == entries.end() || it->second.version != normalize(version))
+                return false;
+            config = it->second.config;
+            return true;
+        }
+
+        void store(const std::string &scope, const std::string &version,
+                   const std::vector<int> &config, float time) {
+            std::lock_guard<std::mutex> lock(mutex);
+            load();
+            hipacc_tuning_entry &entry = entries[normalize(scope)];
+            entry.version = normalize(version);
+            entry.config = config;
+            entry.time = time;
+            write();
+        }
+};
+
+
+std::string hipaccTuningCPUModel() {
+    static std::string model;
+    if (model.empty()) {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") == 0) {
+                size_t pos = line.find_first_not_of(" \t", line.find(':') + 1);
+                if (pos != std::string::npos)
+                    model = line.substr(pos);
+                break;
+            }
+        }
+        if (model.empty())
+            model = "unknown";
+    }
+    return model;
+}
+
+// 64-bit FNV-1a
+std::string hipaccTuningHash(const std::string &data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : data) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
+static void hipaccAppendIncludes(std::string &key, const std::string &source,
+                                 const std::vector<std::string> &include_dirs,
+                                 std::set<std::string> &included) {
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+            continue;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+            continue;
+        size_t begin = line.find_first_of("\"<", pos + 7);
+        size_t end = begin == std::string::npos ? begin : line.find_first_of("\">", begin + 1);
+        if (end == std::string::npos)
+            continue;
+
+        std::string header = line.substr(begin + 1, end - begin - 1);
+        key += '\n' + header;
+        for (auto &dir : include_dirs) {
+            std::string path = dir + "/" + header;
+            std::ifstream file(path);
+            if (!file.is_open())
+                continue;
+            if (included.insert(path).second) {
+                std::string contents(std::istreambuf_iterator<char>(file),
+                                     (std::istreambuf_iterator<char>()));
+                key += '\n' + contents;
+                hipaccAppendIncludes(key, contents, include_dirs, included);
+            }
+            break;
+        }
+    }
+}
+
+void hipaccAppendIncludes(std::string &key, const std::string &source,
+                          const std::vector<std::string> &include_dirs) {
+    std::set<std::string> included;
+    hipaccAppendIncludes(key, source, include_dirs, included);
+}
+
+std::string hipaccTempFile(const std::string &prefix) {
+    #ifdef _WIN32
+    static std::atomic<unsigned> counter(0);
+    for (int i=0; i<100; ++i) {
+        std::string name = prefix + ".tmp" + std::to_string(_getpid()) + "-" + std::to_string(counter++);
+        int fd = _open(name.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY, _S_IREAD | _S_IWRITE);
+        if (fd >= 0) {
+            _close(fd);
+            return name;
+        }
+    }
+    return std::string();
+    #else
+    std::string name = prefix + ".tmpXXXXXX";
+    std::vector<char> buffer(name.begin(), name.end());
+    buffer.push_back('\0');
+    int fd = mkstemp(buffer.data());
+    if (fd < 0) return std::string();
+    // mkstemp creates the file with 0600, the renamed file has to be readable
+    // by everyone like the lock file
+    fchmod(fd, 0644);
+    close(fd);
+    return std::string(buffer.data());
+    #endif
+}
+
+bool hipaccTuningLookup(const std::string &scope, const std::string &version,
+                        std::vector<int> &config) {
+    return HipaccTuningDatabase::getInstance().lookup(scope, version, config);
+}
+
+void hipaccTuningStore(const std::string &scope, const std::string &version,
+                       const std::vector<int> &config, float time) {
+    HipaccTuningDatabase::getInstance().store(scope, version, config, time);
+}
+
+
+#endif // __HIPACC_TUNING_STANDALONE_HPP__
@@ -0,0 +1,458 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+/*
+ * Tool that benchmarks the achievable memory bandwidth of the host CPU for
+ * read, write, copy and triad access patterns per thread count and NUMA node.
+ * The results, together with the cache sizes of the system, are written to a
+ * JSON file to be used as bandwidth ceiling by cost models. The peak
+ * arithmetic throughput is measured as well, so that the file describes the
+ * roofline of the machine (see HIPACC_ROOFLINE in hipacc_metrics.hpp).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+#ifdef __linux__
+# include <sched.h>
+#endif
+#ifdef _OPENMP
+# include <omp.h>
+# define OMP_PRAGMA(x) _Pragma(#x)
+#else
+# define OMP_PRAGMA(x)
+#endif
+
+
+struct cache_info {
+    int level;
+    std::string type;
+    size_t size;
+};
+
+struct bandwidth_result {
+    int node;
+    int threads;
+    double read, write, copy, triad;
+};
+
+
+void usage(char **argv) {
+    std::cout << "Usage: " << argv[0] << " [-h] [-s <memory_size>] [-t <max_threads>] [-r <repetitions>] [-o <output_file>]" << std::endl;
+}
+
+
+std::string read_file(const std::string &name) {
+    std::ifstream file(name);
+    std::string content;
+    std::getline(file, content);
+    return content;
+}
+
+
+// parse cache sizes like "32K" or "8192K" as reported by sysfs
+size_t parse_size(const std::string &str) {
+    size_t size = std::strtoul(str.c_str(), nullptr, 10);
+    if (str.find('K') != std::string::npos) size *= 1024;
+    if (str.find('M') != std::string::npos) size *= 1024*1024;
+    return size;
+}
+
+
+std::vector<cache_info> get_caches() {
+    std::vector<cache_info> caches;
+#ifdef __linux__
+    for (int index=0; ; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::string level = read_file(dir + "level");
+        if (level.empty()) break;
+        caches.push_back({ std::atoi(level.c_str()), read_file(dir + "type"), parse_size(read_file(dir + "size")) });
+    }
+#endif
+    return caches;
+}
+
+
+// CPUs of each NUMA node; a single node without CPU list if unknown
+std::vector<std::vector<int>> get_nodes() {
+    std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+    for (int node=0; ; ++node) {
+        std::string list = read_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (list.empty()) break;
+
+        // cpulist has the format "0-3,8-11"
+        std::vector<int> cpus;
+        std::istringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            int first = 0, last = 0;
+            size_t dash = range.find('-');
+            first = std::atoi(range.substr(0, dash).c_str());
+            last = dash == std::string::npos ? first : std::atoi(range.substr(dash + 1).c_str());
+            for (int cpu=first; cpu<=last; ++cpu) cpus.push_back(cpu);
+        }
+        if (!cpus.empty()) nodes.push_back(cpus);
+    }
+#endif
+    if (nodes.empty()) nodes.push_back(std::vector<int>());
+    return nodes;
+}
+
+
+// pin the calling threads round-robin to the CPUs of a node, so that the
+// first touch places the memory on the same node
+void pin_threads(const std::vector<int> &cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return;
+    OMP_PRAGMA(omp parallel)
+    {
+        int tid = 0;
+        #ifdef _OPENMP
+        tid = omp_get_thread_num();
+        #endif
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[tid % cpus.size()], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#endif
+}
+
+
+// keep the compiler from hoisting the loop-invariant reads of a repeated
+// measurement out of the repetition loop
+inline void clobber_memory(const void *data) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r"(data) : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    (void)data;
+#endif
+}
+
+
+template<typename F>
+double best_time(int repetitions, F func) {
+    double best = 0;
+    for (int i=0; i<repetitions; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        func();
+        auto end = std::chrono::high_resolution_clock::now();
+        double time = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || time < best) best = time;
+    }
+    return best;
+}
+
+
+// sum with independent partial sums: a single accumulator serializes the
+// loads on the latency of the floating-point additions
+double sum_range(const double *data, size_t n) {
+    const int partials = 32;
+    double acc[partials] = { 0 };
+    size_t i = 0;
+    for (; i + partials <= n; i += partials) {
+        OMP_PRAGMA(omp simd)
+        for (int p=0; p<partials; ++p) acc[p] += data[i + p];
+    }
+    double sum = 0;
+    for (; i<n; ++i) sum += data[i];
+    for (int p=0; p<partials; ++p) sum += acc[p];
+    return sum;
+}
+
+
+// STREAM-like kernels; bandwidth in GB/s counting the bytes the kernel
+// explicitly reads and writes
+bandwidth_result measure(size_t size, int threads, int repetitions) {
+    size_t n = size / sizeof(double);
+    double *a = new double[n];
+    double *b = new double[n];
+    double *c = new double[n];
+    const double scalar = 3.0;
+    double bytes = (double)n * sizeof(double) / 1.0e9;
+    volatile double sink = 0;
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    // first touch by the threads that later access the data
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (size_t i=0; i<n; ++i) {
+        a[i] = 1.0; b[i] = 2.0; c[i] = 0.0;
+    }
+
+    bandwidth_result result;
+    result.node = 0;
+    result.threads = threads;
+
+    result.read = bytes / best_time(repetitions, [&] () {
+        double sum = 0;
+        // same partitioning as the static schedule of the first touch
+        OMP_PRAGMA(omp parallel reduction(+:sum))
+        {
+            size_t tid = 0, num_threads = 1;
+            #ifdef _OPENMP
+            tid = omp_get_thread_num();
+            num_threads = omp_get_num_threads();
+            #endif
+            size_t chunk = (n + num_threads - 1) / num_threads;
+            size_t begin = std::min(n, tid * chunk);
+            size_t end = std::min(n, begin + chunk);
+            sum += sum_range(a + begin, end - begin);
+        }
+        sink = sum;
+    });
+    result.write = bytes / best_time(repetitions, [&] () {
+        OMP_PRAGMA(omp parallel for schedule(static))
+        for (size_t i=0; i<n; ++i) c[i] = scalar;
+    });
+    result.copy = 2 * bytes / best_time(repetitions, [&] () {
+        OMP_PRAGMA(omp parallel for schedule(static))
+        for (size_t i=0; i<n; ++i) c[i] = a[i];
+    });
+    result.triad = 3 * bytes / best_time(repetitions, [&] () {
+        OMP_PRAGMA(omp parallel for schedule(static))
+        for (size_t i=0; i<n; ++i) a[i] = b[i] + scalar*c[i];
+    });
+    (void)sink;
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+
+    return result;
+}
+
+
+// independent multiply-add chains per thread: enough vector accumulators to
+// cover the FMA latency (4 cycles) times the FMA ports (2) of current cores
+#if defined(__AVX512F__)
+# define GOPS_LANES 16
+# define GOPS_ISA "AVX-512"
+#elif defined(__AVX__)
+# define GOPS_LANES 8
+# define GOPS_ISA "AVX"
+#else
+# define GOPS_LANES 4
+# define GOPS_ISA "SSE"
+#endif
+#ifdef __FMA__
+# define GOPS_FMA " with FMA"
+#else
+# define GOPS_FMA " without FMA"
+#endif
+#define GOPS_CHAINS (GOPS_LANES * 4 * 2)
+
+// arithmetic throughput in GOP/s, counting a multiply-add as two operations
+// per lane like the operation counts of the roofline
+double measure_gops(int threads, int repetitions) {
+    const size_t iterations = 1 << 22;
+    const int chains = GOPS_CHAINS;
+    volatile float sink = 0;
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    double time = best_time(repetitions, [&] () {
+        OMP_PRAGMA(omp parallel)
+        {
+            float acc[chains];
+            for (int c=0; c<chains; ++c) acc[c] = (float)c;
+            for (size_t i=0; i<iterations; ++i) {
+                OMP_PRAGMA(omp simd)
+                for (int c=0; c<chains; ++c) acc[c] = acc[c] * 0.999f + 0.001f;
+            }
+            float sum = 0;
+            for (int c=0; c<chains; ++c) sum += acc[c];
+            sink = sum;
+        }
+    });
+    (void)sink;
+
+    return 2.0 * chains * iterations * threads / 1.0e9 / time;
+}
+
+
+// single-threaded read bandwidth for growing working sets: the steps of the
+// curve show the cache sizes the kernels actually observe
+std::vector<std::pair<size_t, double>> measure_working_sets(size_t max_size, int repetitions) {
+    std::vector<std::pair<size_t, double>> results;
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    for (size_t size=4096; size<=max_size; size*=2) {
+        size_t n = size / sizeof(double);
+        std::vector<double> data(n, 1.0);
+        // repeat small sets to get measurable times
+        size_t loops = std::max<size_t>(1, (64 << 20) / size);
+        volatile double sink = 0;
+        double time = best_time(repetitions, [&] () {
+            double sum = 0;
+            for (size_t l=0; l<loops; ++l) {
+                sum += sum_range(data.data(), n);
+                clobber_memory(data.data());
+            }
+            sink = sum;
+        });
+        (void)sink;
+        results.push_back(std::make_pair(size, (double)size * loops / 1.0e9 / time));
+    }
+    return results;
+}
+
+
+int main(int argc, char *argv[]) {
+    int option = 0;
+    size_t memory_size = 256*(1 << 20);     //256 M
+    int max_threads = 1;
+    int repetitions = 10;
+    std::string output_file = "cpu_bandwidth.json";
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+
+#ifndef _WIN32
+    // scan command-line options
+    while ((option = getopt(argc, (char * const *)argv, "hs:t:r:o:")) != -1) {
+        switch (option) {
+            case 'h':
+                std::cout << "Bandwidth test for host memory (read, write, copy, triad)." << std::endl;
+                usage(argv);
+                exit(EXIT_SUCCESS);
+            case 's':
+                std::istringstream (optarg) >> memory_size;
+                break;
+            case 't':
+                std::istringstream (optarg) >> max_threads;
+                break;
+            case 'r':
+                std::istringstream (optarg) >> repetitions;
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            default: /* '?' */
+                std::cout << "Wrong call syntax!" << std::endl;
+                usage(argv);
+                exit(EXIT_FAILURE);
+        }
+    }
+#endif
+
+    std::vector<cache_info> caches = get_caches();
+    std::vector<std::vector<int>> nodes = get_nodes();
+
+    std::cout << std::endl << "Bandwidth test, memory size [MB]: " << memory_size/(1024*1024) << std::endl;
+    for (auto &cache : caches) {
+        std::cout << "L" << cache.level << " " << cache.type << " cache [KB]: " << cache.size/1024 << std::endl;
+    }
+
+    // thread counts: powers of two up to the maximum and the maximum itself
+    std::vector<int> thread_counts;
+    for (int threads=1; threads<max_threads; threads*=2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    std::vector<bandwidth_result> results;
+    double peak = 0;
+    for (size_t node=0; node<nodes.size(); ++node) {
+        for (int threads : thread_counts) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            pin_threads(nodes[node]);
+            bandwidth_result result = measure(memory_size, threads, repetitions);
+            result.node = node;
+            results.push_back(result);
+            peak = std::max(peak, std::max(result.copy, result.triad));
+
+            std::cout << "Node " << node << ", threads " << threads
+                      << ": read " << result.read << ", write " << result.write
+                      << ", copy " << result.copy << ", triad " << result.triad
+                      << " [GB/s]" << std::endl;
+        }
+    }
+
+    double peak_gops = measure_gops(max_threads, repetitions);
+    std::cout << "Peak arithmetic throughput [GOP/s]: " << peak_gops
+              << " (" GOPS_ISA GOPS_FMA ")" << std::endl;
+
+    // sweep working sets up to beyond the last level cache
+    size_t max_cache = 0;
+    for (auto &cache : caches) {
+        if (cache.type != "Instruction") max_cache = std::max(max_cache, cache.size);
+    }
+    size_t max_working_set = std::min(std::max<size_t>(4*max_cache, 1 << 20), memory_size);
+    auto working_sets = measure_working_sets(max_working_set, repetitions);
+
+    std::ofstream out(output_file);
+    if (!out) {
+        std::cerr << "ERROR: Could not open output file: " << output_file << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    out << "{\n  \"memory_size\": " << memory_size << ",\n";
+    out << "  \"peak_bandwidth_gb_s\": " << peak << ",\n";
+    out << "  \"peak_gops\": " << peak_gops << ",\n";
+    out << "  \"caches\": [";
+    for (size_t i=0; i<caches.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    {\"level\": " << caches[i].level
+            << ", \"type\": \"" << caches[i].type << "\", \"size\": " << caches[i].size << "}";
+    }
+    out << "\n  ],\n  \"bandwidth\": [";
+    for (size_t i=0; i<results.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    {\"node\": " << results[i].node
+            << ", \"threads\": " << results[i].threads
+            << ", \"read_gb_s\": " << results[i].read
+            << ", \"write_gb_s\": " << results[i].write
+            << ", \"copy_gb_s\": " << results[i].copy
+            << ", \"triad_gb_s\": " << results[i].triad << "}";
+    }
+    out << "\n  ],\n  \"working_set\": [";
+    for (size_t i=0; i<working_sets.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    {\"bytes\": " << working_sets[i].first
+            << ", \"read_gb_s\": " << working_sets[i].second << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    std::cout << "Peak bandwidth [GB/s]: " << peak << std::endl;
+    std::cout << "Results written to " << output_file << std::endl;
+
+    return EXIT_SUCCESS;
+}